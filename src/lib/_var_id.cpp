@@ -1,12 +1,15 @@
 #include "../metaSMT/impl/_var_id.hpp"
 
+#include <boost/detail/atomic_count.hpp>
+
 namespace metaSMT {
   namespace impl {
       unsigned new_var_id(  )
       {
-        static unsigned _id = 0;
-        ++_id;
-        return _id;
+        // function local to be initialized before the first use,
+        // atomic as contexts in different threads create variables
+        static boost::detail::atomic_count _id(0);
+        return ++_id;
       } 
   } /* impl */
 } /* metaSMT */
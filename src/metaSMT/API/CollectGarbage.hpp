@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../Features.hpp"
+
+#include <boost/utility/enable_if.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace metaSMT {
+
+  struct collect_garbage_cmd { typedef std::size_t result_type; };
+
+  /**
+   * \brief reclaim the expressions that are no longer used
+   * \param ctx The context to work on
+   * \param roots The expressions held by the caller, they stay valid and
+   *        are updated in place. Every other expression of ctx is
+   *        invalid afterwards, except those the context keeps itself
+   *        (e.g. assertions).
+   * \return the number of bytes reclaimed
+   *
+   * \code
+   *  GraphSolver_Context< BitBlast< SAT_Clause< MiniSAT > > > ctx;
+   *
+   *  std::vector<SMT_Expression> keep;
+   *  keep.push_back( evaluate(ctx, bvadd(x, y)) );
+   *  // ... many temporary expressions
+   *  std::size_t bytes = collect_garbage(ctx, keep);
+   * \endcode
+   */
+  template <typename Context>
+  typename boost::enable_if<
+    features::supports<Context, collect_garbage_cmd>
+  , std::size_t
+  >::type
+  collect_garbage( Context &ctx, std::vector<typename Context::result_type> & roots ) {
+    return ctx.command(collect_garbage_cmd(), roots);
+  }
+
+  /** \cond */
+  // nothing is reclaimed if collect_garbage is unsupported
+  template <typename Context>
+  typename boost::disable_if<
+    features::supports<Context, collect_garbage_cmd>
+  , std::size_t
+  >::type
+  collect_garbage( Context &, std::vector<typename Context::result_type> & ) {
+    return 0;
+  }
+  /** \endcond **/
+
+} /* metaSMT */
@@ -1,20 +1,39 @@
 #pragma once
 
 #include "tags/QF_BV.hpp"
+#include "tags/Array.hpp"
+#include "tags/QF_UF.hpp"
 #include "result_wrapper.hpp"
+#include "support/BitVectorView.hpp"
+#include "support/GateCache.hpp"
+#include "support/Options.hpp"
 
 #include <boost/mpl/vector.hpp>
 #include <boost/proto/core.hpp>
 #include <boost/variant.hpp>
 #include <boost/any.hpp>
+#include <boost/dynamic_bitset.hpp>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/tr1/unordered_map.hpp>
+#include <boost/utility/enable_if.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace metaSMT {
   namespace proto = boost::proto;
   namespace bvtags = ::metaSMT::logic::QF_BV::tag;
   namespace predtags = ::metaSMT::logic::tag;
+  namespace arraytags = ::metaSMT::logic::Array::tag;
+  namespace uftags = ::metaSMT::logic::QF_UF::tag;
 
   // Forward declaration
   struct addclause_cmd;
@@ -28,14 +47,46 @@ namespace metaSMT {
     typedef BitBlast<PredicateSolver> this_type;
 
     typedef typename PredicateSolver::result_type result_base;
-    typedef std::vector< result_base >  bv_result;
-
-    typedef typename boost::mpl::vector2<
-      result_base, bv_result
+    typedef BitVectorView< result_base > bv_result;
+    typedef std::vector< result_base > bits_type;
+
+    /**
+     * a store on an array term, the stores of a term form a list from
+     * the most recent to the first one.
+     **/
+    struct array_store {
+      bv_result index;
+      bv_result value;
+      boost::shared_ptr< array_store const > next;
+    };
+
+    /**
+     * an array term: a base array variable and the stores on top of it
+     **/
+    struct array_result {
+      unsigned base;
+      boost::shared_ptr< array_store const > stores;
+    };
+
+    /**
+     * an uninterpreted function, see the function_var_tag operator
+     **/
+    struct function_result {
+      unsigned id;
+    };
+
+    typedef typename boost::mpl::vector4<
+      result_base, bv_result, array_result, function_result
     >::type result_types_vec;
 
     typedef typename boost::make_variant_over< result_types_vec >::type 
       result_type;
+
+        BitBlast()
+          : _gates(_solver)
+        {
+          configure();
+        }
       
     
         void assertion( result_type e ) { 
@@ -43,465 +94,230 @@ namespace metaSMT {
         }
 
         void assumption( result_type e ) { 
-          _solver.assumption( boost::get<result_base>(e) );
+          _assumptions.push_back( boost::get<result_base>(e) );
+          _solver.assumption( _assumptions.back() );
         }
         
+        /**
+         * solves and refines the array lemmas and lazy operators until
+         * the model is consistent with them, see refine().
+         **/
         bool solve() {
-          return _solver.solve();
+          bool sat = _solver.solve();
+          while ( sat && refine() ) {
+            BOOST_FOREACH( result_base const & a, _assumptions ) {
+              _solver.assumption(a);
+            }
+            sat = _solver.solve();
+          }
+          _assumptions.clear();
+          return sat;
         }
 
         result_type operator() (bvtags::var_tag var, boost::any arg ) {
           //printf("bitvec\n");
           bv_result ret(var.width);
           for (unsigned i = 0; i < var.width; ++i) {
-            ret[i]= _solver(predtags::var_tag(), arg);
+            ret[i]= _gates(predtags::var_tag(), arg);
           }
           return ret;
         }
 
-        result_type operator() ( bvtags::bvand_tag , result_type arg1, result_type arg2 ) 
+        result_type operator() ( bvtags::bvand_tag , result_type const & arg1, result_type const & arg2 ) 
         {
           //printf("bvand\n");
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
           assert(a.size()==b.size());
           bv_result ret(a.size());
           predtags::and_tag and_;
 
           for (unsigned i = 0; i < a.size(); ++i) {
-            ret[i]= _solver(and_, a[i], b[i]);
+            ret[i]= _gates(and_, a[i], b[i]);
           }
           return ret;
         }
         
         
-        result_type operator() ( bvtags::bvnand_tag , result_type arg1, result_type arg2 ) 
+        result_type operator() ( bvtags::bvnand_tag , result_type const & arg1, result_type const & arg2 ) 
         {
           //printf("bvnand\n");
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
           assert(a.size()==b.size());
           bv_result ret(a.size());
           predtags::nand_tag nand_;
 
           for (unsigned i = 0; i < a.size(); ++i) {
-            ret[i]= _solver(nand_, a[i], b[i]);
+            ret[i]= _gates(nand_, a[i], b[i]);
           }
           return ret;
         }
         
-        result_type operator() ( bvtags::bvor_tag , result_type arg1, result_type arg2 ) 
+        result_type operator() ( bvtags::bvor_tag , result_type const & arg1, result_type const & arg2 ) 
         {
           //printf("bvor\n");
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
           assert(a.size()==b.size());
           bv_result ret(a.size());
           predtags::or_tag or_;
 
           for (unsigned i = 0; i < a.size(); ++i) {
-            ret[i]= _solver(or_, a[i], b[i]);
+            ret[i]= _gates(or_, a[i], b[i]);
           }
           return ret;
         }
       
-        result_type operator() ( bvtags::bvnor_tag , result_type arg1, result_type arg2 ) 
+        result_type operator() ( bvtags::bvnor_tag , result_type const & arg1, result_type const & arg2 ) 
         {
           //printf("bvnor\n");
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
           assert(a.size()==b.size());
           bv_result ret(a.size());
           predtags::nor_tag tag_;
 
           for (unsigned i = 0; i < a.size(); ++i) {
-            ret[i]= _solver(tag_, a[i], b[i]);
+            ret[i]= _gates(tag_, a[i], b[i]);
           }
           return ret;
         }
            
-        result_type operator() ( bvtags::bvnot_tag , result_type arg1 ) 
+        result_type operator() ( bvtags::bvnot_tag , result_type const & arg1 ) 
         {
          //printf("bvnot\n");
-          bv_result a = boost::get<bv_result>(arg1);
+          bv_result const & a = boost::get<bv_result>(arg1);
           bv_result ret(a.size());
           predtags::not_tag not_;
           
           for (unsigned i = 0; i < a.size(); ++i) {
-            ret[i] = _solver(not_,a[i]);
+            ret[i] = _gates(not_,a[i]);
           }
           return ret;
         }
        
        
-       result_type operator() ( bvtags::bvxor_tag , result_type arg1, result_type arg2 ) 
+       result_type operator() ( bvtags::bvxor_tag , result_type const & arg1, result_type const & arg2 ) 
        {
           //printf("bvxor\n");
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
           assert(a.size()==b.size());
           bv_result ret(a.size());
           predtags::xor_tag xor_;
 
           for (unsigned i = 0; i < a.size(); ++i) {
-            ret[i]= _solver(xor_, a[i], b[i]);
+            ret[i]= _gates(xor_, a[i], b[i]);
           }
           return ret;
        }
        
-       result_type operator() ( bvtags::bvxnor_tag , result_type arg1, result_type arg2 ) 
+       result_type operator() ( bvtags::bvxnor_tag , result_type const & arg1, result_type const & arg2 ) 
        {
           //printf("bvxnor\n");
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
           assert(a.size()==b.size());
           bv_result ret(a.size());
           predtags::xnor_tag xnor_;
 
           for (unsigned i = 0; i < a.size(); ++i) {
-            ret[i]= _solver(xnor_, a[i], b[i]);
+            ret[i]= _gates(xnor_, a[i], b[i]);
           }
           return ret;
         }
       
       
-       result_type operator() (bvtags::bvult_tag, result_type arg1, result_type arg2)
+       result_type operator() (bvtags::bvult_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          
-          result_base not_a = _solver(predtags::not_tag(), *ai);
-          result_base ret = _solver(predtags::and_tag(),not_a, *bi);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-         
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            not_a = _solver(predtags::not_tag(), *ai);
-            result_base now_less = _solver(predtags::and_tag(),not_a, *bi);
-            result_base now   = _solver(predtags::and_tag(), equal, now_less);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          return ret;
+          return lessThan( boost::get<bv_result>(arg1), boost::get<bv_result>(arg2), false, false );
        }
        
-       result_type operator() (bvtags::bvugt_tag, result_type arg1, result_type arg2)
+       result_type operator() (bvtags::bvugt_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          
-          result_base not_b = _solver(predtags::not_tag(), *bi);
-          result_base ret = _solver(predtags::and_tag(), *ai, not_b);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-         
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            not_b = _solver(predtags::not_tag(), *bi);
-            result_base now_great = _solver(predtags::and_tag(),*ai, not_b);
-            result_base now   = _solver(predtags::and_tag(), equal, now_great);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          return ret;
+          return lessThan( boost::get<bv_result>(arg2), boost::get<bv_result>(arg1), false, false );
        }
        
-       result_type operator() (bvtags::bvsgt_tag, result_type arg1, result_type arg2)
+       result_type operator() (bvtags::bvsgt_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          result_base not_a = _solver(predtags::not_tag(), *ai);
-          result_base not_b = _solver(predtags::not_tag(), *bi);
-          result_base ret = _solver(predtags::and_tag(), not_a, *bi);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-         
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            not_b = _solver(predtags::not_tag(), *bi);
-            
-            result_base now_great = _solver(predtags::and_tag(),*ai, not_b);
-            result_base now   = _solver(predtags::and_tag(), equal, now_great);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          return ret;
+          return lessThan( boost::get<bv_result>(arg2), boost::get<bv_result>(arg1), false, true );
        }
        
 
-        result_type operator() (bvtags::bvslt_tag, result_type arg1, result_type arg2)
+        result_type operator() (bvtags::bvslt_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          result_base not_a = _solver(predtags::not_tag(), *ai);
-          result_base not_b = _solver(predtags::not_tag(), *bi);
-          result_base ret = _solver(predtags::and_tag(), *ai, not_b);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-         
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            not_a = _solver(predtags::not_tag(), *ai);
-            result_base now_less = _solver(predtags::and_tag(),not_a, *bi);
-            result_base now   = _solver(predtags::and_tag(), equal, now_less);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          return ret;
+          return lessThan( boost::get<bv_result>(arg1), boost::get<bv_result>(arg2), false, true );
        }
        
        
-        result_type operator() (bvtags::bvule_tag, result_type arg1, result_type arg2)
-        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          result_base not_a = _solver(predtags::not_tag(), *ai);
-        //  result_base not_b = _solver(predtags::not_tag(), *bi);
-          result_base less = _solver(predtags::and_tag(), not_a, *bi);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-          result_base ret = less; 
-          
-          
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            not_a = _solver(predtags::not_tag(), *ai);
-            result_base now_less = _solver(predtags::and_tag(),not_a, *bi);
-            result_base now   = _solver(predtags::and_tag(), equal, now_less);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          ret = _solver(predtags::or_tag(), ret, equal);
-          return ret;
-        }
+        result_type operator() (bvtags::bvule_tag, result_type const & arg1, result_type const & arg2)
+       {
+          return lessThan( boost::get<bv_result>(arg1), boost::get<bv_result>(arg2), true, false );
+       }
         
         
 
 
-        result_type operator() (bvtags::bvuge_tag, result_type arg1, result_type arg2)
-        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          result_base not_b = _solver(predtags::not_tag(), *bi);
-        //  result_base not_b = _solver(predtags::not_tag(), *bi);
-          result_base great = _solver(predtags::and_tag(), *ai, not_b);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-          result_base ret = great;
-
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            not_b = _solver(predtags::not_tag(), *bi);
-            result_base now_great = _solver(predtags::and_tag(),*ai, not_b);
-            result_base now   = _solver(predtags::and_tag(), equal, now_great);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          ret = _solver(predtags::or_tag(), ret, equal);
-          return ret;
-        }
+        result_type operator() (bvtags::bvuge_tag, result_type const & arg1, result_type const & arg2)
+       {
+          return lessThan( boost::get<bv_result>(arg2), boost::get<bv_result>(arg1), true, false );
+       }
        
-       result_type operator() (bvtags::bvsge_tag, result_type arg1, result_type arg2)
+       result_type operator() (bvtags::bvsge_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          result_base not_a = _solver(predtags::not_tag(), *ai);
-          result_base not_b = _solver(predtags::not_tag(), *bi);
-          result_base great = _solver(predtags::and_tag(), not_a, *bi);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-          result_base ret = great;
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            not_b = _solver(predtags::not_tag(), *bi);
-            result_base now_great = _solver(predtags::and_tag(),*ai, not_b);
-            result_base now   = _solver(predtags::and_tag(), equal, now_great);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          ret = _solver(predtags::or_tag(), ret, equal);
-          return ret;
+          return lessThan( boost::get<bv_result>(arg2), boost::get<bv_result>(arg1), true, true );
        }
        
 
-        result_type operator() (bvtags::bvsle_tag, result_type arg1, result_type arg2)
+        result_type operator() (bvtags::bvsle_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          assert(a.size()==b.size());
-          assert(a.size()>0);
-          
-          typename bv_result::reverse_iterator ai, bi, end;
-          ai = a.rbegin();
-          bi = b.rbegin();
-          end= a.rend();
-                  
-          result_base not_b = _solver(predtags::not_tag(), *bi);
-          result_base less = _solver(predtags::and_tag(), *ai, not_b);  
-          result_base equal = _solver(predtags::xnor_tag(), *ai, *bi);
-          result_base ret = less;
-
-          for (++ai, ++bi ; ai != end; ++ai, ++bi) 
-          {
-            result_base not_a = _solver(predtags::not_tag(), *ai);
-            result_base now_less = _solver(predtags::and_tag(),not_a, *bi);
-            result_base now   = _solver(predtags::and_tag(), equal, now_less);
-            
-            result_base now_equal = _solver(predtags::xnor_tag(), *ai, *bi);
-            equal = _solver(predtags::and_tag(), now_equal, equal);
-
-            ret = _solver(predtags::or_tag(), ret, now);
-          }
-          ret = _solver(predtags::or_tag(), ret, equal);
-          return ret;
+          return lessThan( boost::get<bv_result>(arg1), boost::get<bv_result>(arg2), true, true );
        }
        
-        result_type operator() (bvtags::bvadd_tag, result_type arg1, result_type arg2)
+        result_type operator() (bvtags::bvadd_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
           assert(a.size()==b.size());
-          
-          bv_result ret(a.size());
-          
-          result_base carry = _solver(predtags::false_tag(), boost::any());
-          
-          result_base xor1, or1, and1, and2;
-         
-          for (unsigned i = 0; i < a.size(); ++i) {
-              
-              xor1 = _solver(predtags::xor_tag(), a[i], b[i]);
-              ret[i] = _solver(predtags::xor_tag(), xor1, carry);
-              
-              // a&b | c&(a|b) 
-              and1 = _solver(predtags::and_tag(), a[i], b[i]);
-              or1  = _solver(predtags::or_tag(),a[i],b[i]);
-              and2 = _solver(predtags::and_tag(),carry, or1);
-              carry  = _solver(predtags::or_tag(), and1, and2);
-                          
-            }
-          return ret;
+
+          return addWithCarry(a, b, _gates(predtags::false_tag(), boost::any()));
        }
 
-       result_type operator() (bvtags::bvmul_tag, result_type arg1, result_type arg2)
+       result_type operator() (bvtags::bvmul_tag, result_type const & arg1, result_type const & arg2)
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-          result_type ret = bv_result (a.size(), _solver( predtags::false_tag(), boost::any() ) );
-          result_type tmp1;
-          
-          for(unsigned i = 0 ; i < a.size() ; ++i)
-          {
-            tmp1 = (*this)(bvtags::sign_extend_tag(),a.size()-1,bv_result(1,a[i]));
-            tmp1 = (*this)(bvtags::bvand_tag(),arg2,tmp1);
-            tmp1 = shiftL( boost::get<bv_result>(tmp1),i);
-            
-            ret = (*this)(bvtags::bvadd_tag(),ret,tmp1);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & b = boost::get<bv_result>(arg2);
+          assert(a.size()==b.size());
+
+          if ( isLazy(a, b) ) {
+            return lazyOperator(LAZY_MUL, a, b);
           }
-          return ret;
+          return multiply(a, b);
        }
      
-       result_type operator() ( bvtags::bvneg_tag, result_type arg1 )
+       result_type operator() ( bvtags::bvneg_tag, result_type const & arg1 )
        {
        
-          bv_result a = boost::get<bv_result>(arg1);
-          
-          bv_result tmp1(a.size(),_solver(predtags::false_tag(),boost::any()));
-          tmp1.front()= _solver(predtags::true_tag(), boost::any());
-          result_type tmp2 = (*this)(bvtags::bvnot_tag(), arg1);
-          
-          return (*this)(bvtags::bvadd_tag(),tmp2,tmp1);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result zero(a.size(), _gates(predtags::false_tag(), boost::any()));
+          result_type not_a = (*this)(bvtags::bvnot_tag(), arg1);
+
+          return addWithCarry(boost::get<bv_result>(not_a), zero
+              , _gates(predtags::true_tag(), boost::any()));
        }
        
-       result_type operator() ( bvtags::bvudiv_tag, result_type arg1, result_type arg2 )
+       result_type operator() ( bvtags::bvudiv_tag, result_type const & arg1, result_type const & arg2 )
        {
             return uDivRem(arg1,arg2,true);
        }
    
-       result_type operator() ( bvtags::bvsdiv_tag, result_type arg1, result_type arg2 )
+       result_type operator() ( bvtags::bvsdiv_tag, result_type const & arg1, result_type const & arg2 )
        {
         return sDivRem(arg1,arg2,true); 
        }
 
-       result_type operator() ( bvtags::bvsrem_tag, result_type arg1, result_type arg2 )
+       result_type operator() ( bvtags::bvsrem_tag, result_type const & arg1, result_type const & arg2 )
        {
         return sDivRem(arg1,arg2,false); 
        }
@@ -509,8 +325,8 @@ namespace metaSMT {
      result_type operator() ( bvtags::bvhex_tag , boost::any arg )
        {
                std::string str = boost::any_cast<std::string>(arg);
-               result_base _0 = _solver(predtags::false_tag(),boost::any());               
-               result_base _1 = _solver(predtags::true_tag(),boost::any());               
+               result_base _0 = _gates(predtags::false_tag(),boost::any());               
+               result_base _1 = _gates(predtags::true_tag(),boost::any());               
                bv_result ret(str.size()*4,_0);
                typename bv_result::iterator iter = ret.begin();
           
@@ -625,19 +441,23 @@ namespace metaSMT {
           
        }
       
-       result_type operator() ( bvtags::bvurem_tag, result_type arg1, result_type arg2 )
+       result_type operator() ( bvtags::bvurem_tag, result_type const & arg1, result_type const & arg2 )
        {
             return uDivRem(arg1,arg2, false);
        }
             
-       result_type operator() ( bvtags::bvsub_tag, result_type arg1, result_type arg2 )
+       result_type operator() ( bvtags::bvsub_tag, result_type const & arg1, result_type const & arg2 )
        {
-          result_type tmp ((*this)(bvtags::bvneg_tag(), arg2));
-                          
-           return (*this)(bvtags::bvadd_tag(), arg1,tmp);
+          bv_result const & a = boost::get<bv_result>(arg1);
+          assert(a.size()==boost::get<bv_result>(arg2).size());
+          result_type not_b = (*this)(bvtags::bvnot_tag(), arg2);
+
+          // a - b = a + ~b + 1
+          return addWithCarry(a, boost::get<bv_result>(not_b)
+              , _gates(predtags::true_tag(), boost::any()));
        }
 
-     result_type operator() ( bvtags::bvcomp_tag, result_type arg1, result_type arg2 )
+     result_type operator() ( bvtags::bvcomp_tag, result_type const & arg1, result_type const & arg2 )
        {
           result_type tmp = (*this)(predtags::equal_tag(), arg1,arg2);
           
@@ -646,40 +466,37 @@ namespace metaSMT {
           return bv_result(1,ret);
        }
 
-       result_type operator() ( bvtags::zero_extend_tag, unsigned width, result_type arg1 ) 
+       result_type operator() ( bvtags::zero_extend_tag, unsigned width, result_type const & arg1 ) 
        {
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result tmp(a.size()+width,_solver(predtags::false_tag(),boost::any()));
-          
-          std::copy(a.begin(), a.end(), tmp.begin());
-          return tmp;
+          bv_result const & a = boost::get<bv_result>(arg1);
+          return bv_result::concat(a, bv_result(width, _gates(predtags::false_tag(), boost::any())));
        }
        
-       result_type operator() ( bvtags::sign_extend_tag, unsigned width, result_type arg1 ) 
+       result_type operator() ( bvtags::sign_extend_tag, unsigned width, result_type const & arg1 ) 
        {
-          bv_result a = boost::get<bv_result>(arg1);
+          bv_result const & a = boost::get<bv_result>(arg1);
           assert(!a.empty());
-          bv_result tmp(a.size()+width, a.back());
-          
-          std::copy(a.begin(), a.end(), tmp.begin());
-          return tmp;
+          return bv_result::concat(a, bv_result(width, a.back()));
        }
        
 
-       result_type operator() ( predtags::equal_tag eq, result_type arg1, result_type arg2 ) 
+       result_type operator() ( predtags::equal_tag eq, result_type const & arg1, result_type const & arg2 ) 
        {
+          if ( array_result const * a = boost::get<array_result>(&arg1) ) {
+            return arrayEqual( *a, boost::get<array_result>(arg2) );
+          }
           result_base ret;
           //printf("try to compare bv\n");
           try {
             //printf("read arg1\n");
-            bv_result a = boost::get<bv_result>(arg1);
+            bv_result const & a = boost::get<bv_result>(arg1);
             //printf("read arg2\n");
-            bv_result b = boost::get<bv_result>(arg2);
+            bv_result const & b = boost::get<bv_result>(arg2);
             assert(a.size()==b.size());
-            ret = _solver(predtags::true_tag(), boost::any());
+            ret = _gates(predtags::true_tag(), boost::any());
             for (unsigned i = 0; i < a.size(); ++i) {
-              result_base cur = _solver(eq, a[i], b[i]);
-              ret = _solver(predtags::and_tag(), cur, ret);
+              result_base cur = _gates(eq, a[i], b[i]);
+              ret = _gates(predtags::and_tag(), cur, ret);
             }
           } catch (boost::bad_get) {
             //printf("try to compare bool\n");
@@ -687,26 +504,30 @@ namespace metaSMT {
             result_base a = boost::get<result_base>(arg1);
             //printf("read arg2\n");
             result_base b = boost::get<result_base>(arg2);
-            ret = _solver(eq, a, b);
+            ret = _gates(eq, a, b);
           }
           //printf("compare done\n");
           return ret;
        }
 
-       result_type operator() ( predtags::nequal_tag neq, result_type arg1, result_type arg2 ) 
+       result_type operator() ( predtags::nequal_tag neq, result_type const & arg1, result_type const & arg2 ) 
        {
+          if ( array_result const * a = boost::get<array_result>(&arg1) ) {
+            return _gates( predtags::not_tag()
+              , arrayEqual( *a, boost::get<array_result>(arg2) ) );
+          }
           result_base ret;
           //printf("try to compare bv\n");
           try {
             //printf("read arg1\n");
-            bv_result a = boost::get<bv_result>(arg1);
+            bv_result const & a = boost::get<bv_result>(arg1);
             //printf("read arg2\n");
-            bv_result b = boost::get<bv_result>(arg2);
+            bv_result const & b = boost::get<bv_result>(arg2);
             assert(a.size()==b.size());
-            ret = _solver(predtags::false_tag(), boost::any());
+            ret = _gates(predtags::false_tag(), boost::any());
             for (unsigned i = 0; i < a.size(); ++i) {
-              result_base cur = _solver(neq, a[i], b[i]);
-              ret = _solver(predtags::or_tag(), cur, ret);
+              result_base cur = _gates(neq, a[i], b[i]);
+              ret = _gates(predtags::or_tag(), cur, ret);
             }
           } catch (boost::bad_get) {
             //printf("try to compare bool\n");
@@ -714,7 +535,7 @@ namespace metaSMT {
             result_base a = boost::get<result_base>(arg1);
             //printf("read arg2\n");
             result_base b = boost::get<result_base>(arg2);
-            ret = _solver(neq, a, b);
+            ret = _gates(neq, a, b);
           }
           //printf("compare done\n");
           return ret;
@@ -725,8 +546,8 @@ namespace metaSMT {
           //printf("bvbin\n");
           std::string value = boost::any_cast<std::string>(arg);
           bv_result ret (value.size());
-          result_base one  = _solver(predtags::true_tag (), boost::any());
-          result_base zero = _solver(predtags::false_tag(), boost::any());
+          result_base one  = _gates(predtags::true_tag (), boost::any());
+          result_base zero = _gates(predtags::false_tag(), boost::any());
           std::string::reverse_iterator vite = value.rbegin();
           typename bv_result::iterator rite = ret.begin();
           for (unsigned i = 0; i < value.size(); ++i) {
@@ -745,8 +566,8 @@ namespace metaSMT {
           unsigned long width = boost::get<1>(p);
         
           bv_result ret (width);
-          result_base one  = _solver(predtags::true_tag (), boost::any());
-          result_base zero = _solver(predtags::false_tag(), boost::any());
+          result_base one  = _gates(predtags::true_tag (), boost::any());
+          result_base zero = _gates(predtags::false_tag(), boost::any());
           for (unsigned long i = 0; i < width; ++i) {
             ret[i] = (value & 1) ? one : zero;
             value >>=1;
@@ -761,8 +582,8 @@ namespace metaSMT {
           unsigned long width = boost::get<1>(p);
         
           bv_result ret (width);
-          result_base one  = _solver(predtags::true_tag (), boost::any());
-          result_base zero = _solver(predtags::false_tag(), boost::any());
+          result_base one  = _gates(predtags::true_tag (), boost::any());
+          result_base zero = _gates(predtags::false_tag(), boost::any());
           for (unsigned long i = 0; i < width; ++i) {
             ret[i] = (value & 1) ? one : zero;
             value >>=1;
@@ -773,90 +594,50 @@ namespace metaSMT {
         
         result_type operator() (bvtags::bit0_tag , boost::any arg ) {
           //printf("bit0\n");
-          return bv_result(1,_solver(predtags::false_tag(), arg));
+          return bv_result(1,_gates(predtags::false_tag(), arg));
         }
 
         result_type operator() (bvtags::bit1_tag , boost::any arg ) {
           //printf("bit1\n");
-          return bv_result(1,_solver(predtags::true_tag(), arg));
+          return bv_result(1,_gates(predtags::true_tag(), arg));
         }
 
-        result_type operator() (bvtags::bvshr_tag, result_type arg1, result_type value) {
-          bv_result a = boost::get<bv_result>(arg1);
-          
-          result_base zero = _solver(predtags::false_tag(),boost::any());
-          result_type ret = bv_result(a.size(), zero);
-          predtags:: ite_tag ite;
-          
-          for(unsigned i = 0; i < a.size(); ++i)
-          {
-            result_type index = (*this)(bvtags::bvuint_tag()
-                ,boost::any(boost::tuple<unsigned long, unsigned long>(i,a.size())));
-            ret = (*this)(ite, 
-                (*this)(predtags::equal_tag(), value, index)
-              , shiftR(a, i, zero)
-              , ret
-            );
-          }
-         
-          return ret; 
+        result_type operator() (bvtags::bvshr_tag, result_type const & arg1, result_type const & value) {
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & v = boost::get<bv_result>(value);
+          result_base zero = _gates(predtags::false_tag(),boost::any());
+          return barrelShift(a, v, false, zero);
         }
       
-        result_type operator() (bvtags::bvshl_tag, result_type arg1, result_type value ) {
-          
-          bv_result a = boost::get<bv_result>(arg1);
-          
-          result_type ret = bv_result(a.size(), _solver(predtags::false_tag(), boost::any()));
-          predtags:: ite_tag ite;
-          
-          for(unsigned i = 0; i < a.size(); ++i)
-          {
-            result_type index = (*this)(bvtags::bvuint_tag()
-                ,boost::any(boost::tuple<unsigned long, unsigned long>(i,a.size())));
-            ret = (*this)(ite, 
-                (*this)(predtags::equal_tag(), value, index)
-              , shiftL(a, i)
-              , ret
-            );
-          }
-          return ret;         
+        result_type operator() (bvtags::bvshl_tag, result_type const & arg1, result_type const & value ) {
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & v = boost::get<bv_result>(value);
+          result_base zero = _gates(predtags::false_tag(),boost::any());
+          return barrelShift(a, v, true, zero);
         }
         
-        result_type operator() (bvtags::bvashr_tag, result_type arg1, result_type value ) {
-        bv_result a = boost::get<bv_result>(arg1);
-          
- 
-          result_type ret = bv_result(a.size(), a.back());
-          predtags:: ite_tag ite;
-          
-          for(unsigned i = 0; i < a.size(); ++i)
-          {
-            result_type index = (*this)(bvtags::bvuint_tag()
-                ,boost::any(boost::tuple<unsigned long, unsigned long>(i,a.size())));
-            ret = (*this)(ite, 
-                (*this)(predtags::equal_tag(), value, index)
-              , shiftR(a, i, a.back())
-              , ret
-            );
-          }
-         
-          return ret; 
+        result_type operator() (bvtags::bvashr_tag, result_type const & arg1, result_type const & value ) {
+          bv_result const & a = boost::get<bv_result>(arg1);
+          bv_result const & v = boost::get<bv_result>(value);
+          assert(!a.empty());
+          result_base sign = a.back();
+          return barrelShift(a, v, false, sign);
         }
         
         
-        result_type operator() (predtags::ite_tag, result_type arg1, result_type arg2, result_type arg3 ) {
+        result_type operator() (predtags::ite_tag, result_type const & arg1, result_type const & arg2, result_type const & arg3 ) {
                  
           result_base c = boost::get<result_base>(arg1);
           predtags::ite_tag ite;
           
           try {
-           bv_result a = boost::get<bv_result>(arg2);
-           bv_result b = boost::get<bv_result>(arg3);
+           bv_result const & a = boost::get<bv_result>(arg2);
+           bv_result const & b = boost::get<bv_result>(arg3);
            bv_result ret(a.size());
            assert(a.size()==b.size());
           
            for (unsigned i = 0; i < a.size(); ++i) {
-               ret[i]= _solver(ite,c,a[i],b[i]);
+               ret[i]= _gates(ite,c,a[i],b[i]);
            }
           
            return ret;
@@ -864,7 +645,7 @@ namespace metaSMT {
            catch (boost::bad_get) {
            result_base a = boost::get<result_base>(arg2);
            result_base b = boost::get<result_base>(arg3);
-            return _solver(ite,c,a,b); 
+            return _gates(ite,c,a,b); 
           }
           
          
@@ -883,26 +664,120 @@ namespace metaSMT {
 
         result_type operator() (bvtags::extract_tag const & 
             , unsigned long upper, unsigned long lower
-            , result_type e
+            , result_type const & e
         ) {
-          bv_result ret(upper-lower+1);
           bv_result bv = boost::apply_visitor(bv_getter(), e);
-          std::copy(bv.begin()+lower, bv.begin()+upper+1, ret.begin());
-          return ret;
+          return bv.slice(lower, upper-lower+1);
         }
 
         result_type operator() (bvtags::concat_tag const & 
-            , result_type e1, result_type e2
+            , result_type const & e1, result_type const & e2
         ) {
           bv_result bv1 = boost::apply_visitor(bv_getter(), e1);
           bv_result bv2 = boost::apply_visitor(bv_getter(), e2);
-          bv_result ret(bv1.size()+bv2.size());
-          std::copy(bv2.begin(), bv2.end(), ret.begin() );
-          std::copy(bv1.begin(), bv1.end(), ret.begin() + bv2.size() );
+          return bv_result::concat(bv2, bv1);
+        }
+
+        result_type operator() (arraytags::array_var_tag const & var, boost::any )
+        {
+          ArrayBase base;
+          base.elem_width = var.elem_width;
+          base.index_width = var.index_width;
+          _arrays.push_back(base);
+
+          array_result ret;
+          ret.base = _arrays.size()-1;
+          return ret;
+        }
+
+        result_type operator() (arraytags::select_tag const &
+            , result_type const & array, result_type const & index )
+        {
+          return select( boost::get<array_result>(array), boost::get<bv_result>(index) );
+        }
+
+        result_type operator() (arraytags::store_tag const &
+            , result_type const & array, result_type const & index
+            , result_type const & value )
+        {
+          array_result const & a = boost::get<array_result>(array);
+          ArrayBase const & base = _arrays[a.base];
+          boost::shared_ptr< array_store > st( new array_store() );
+          st->index = boost::get<bv_result>(index);
+          st->value = boost::get<bv_result>(value);
+          if ( st->index.size() != base.index_width
+            || st->value.size() != base.elem_width ) {
+            throw std::invalid_argument("store: width does not match the array");
+          }
+          st->next = a.stores;
+
+          array_result ret;
+          ret.base = a.base;
+          ret.stores = st;
           return ret;
         }
 
-        result_wrapper read_value(result_type var)
+        /**
+         * uninterpreted functions are Ackermann reduced: a function is
+         * an array indexed by the concatenation of its arguments and each
+         * application is a read of it. The functional consistency of two
+         * applications is the read lemma of the two reads.
+         **/
+        result_type operator() (uftags::function_var_tag const & var, boost::any )
+        {
+          Function f;
+          f.boolean = boost::get<type::Boolean>(&var.result_type) != 0;
+          unsigned index_width = 0;
+          BOOST_FOREACH( type::any_type const & arg, var.args ) {
+            f.arg_widths.push_back( typeWidth(arg) );
+            index_width += f.arg_widths.back();
+          }
+
+          ArrayBase base;
+          base.elem_width = typeWidth(var.result_type);
+          base.index_width = index_width;
+          base.function = true;
+          _arrays.push_back(base);
+          f.base = _arrays.size()-1;
+          _functions.push_back(f);
+
+          function_result ret;
+          ret.id = _functions.size()-1;
+          return ret;
+        }
+
+        result_type operator() (proto::tag::function, result_type const & func) {
+          return apply(func, std::vector< result_type >());
+        }
+
+        result_type operator() (proto::tag::function, result_type const & func
+            , result_type const & arg1)
+        {
+          std::vector< result_type > args(1, arg1);
+          return apply(func, args);
+        }
+
+        result_type operator() (proto::tag::function, result_type const & func
+            , result_type const & arg1, result_type const & arg2)
+        {
+          std::vector< result_type > args;
+          args.push_back(arg1);
+          args.push_back(arg2);
+          return apply(func, args);
+        }
+
+        result_type operator() (proto::tag::function, result_type const & func
+            , result_type const & arg1, result_type const & arg2
+            , result_type const & arg3)
+        {
+          std::vector< result_type > args;
+          args.push_back(arg1);
+          args.push_back(arg2);
+          args.push_back(arg3);
+          return apply(func, args);
+        }
+
+        result_wrapper read_value(result_type const & var)
         { 
           try {
             return read_value(boost::get<result_base>(var)); 
@@ -939,7 +814,7 @@ namespace metaSMT {
         operator() (TagT tag, Any args ) {
           try {
             // std::cout << "operator " << tag << std::endl;
-           return _solver(tag, args);
+           return _gates(tag, args);
           } catch (boost::bad_get) {
             std::cout << "Error bad_get in operator " << typeid(tag).name() << std::endl;
             throw;
@@ -947,16 +822,16 @@ namespace metaSMT {
         }
 
         template <typename TagT>
-        result_type operator() (TagT tag, result_type a ) {
-          return _solver( tag
+        result_type operator() (TagT tag, result_type const & a ) {
+          return _gates( tag
             , boost::get<result_base>(a)
           );
         }
 
         template <typename TagT>
-        result_type operator() (TagT tag, result_type a, result_type b) {
+        result_type operator() (TagT tag, result_type const & a, result_type const & b) {
           try {
-          return _solver( tag
+          return _gates( tag
             , boost::get<result_base>(a)
             , boost::get<result_base>(b)
           );
@@ -967,9 +842,9 @@ namespace metaSMT {
         }
 
         template <typename TagT>
-        result_type operator() (TagT tag, result_type a, result_type b, result_type c) {
+        result_type operator() (TagT tag, result_type const & a, result_type const & b, result_type const & c) {
           try {
-          return _solver( tag
+          return _gates( tag
             , boost::get<result_base>(a)
             , boost::get<result_base>(b)
             , boost::get<result_base>(c)
@@ -988,154 +863,1230 @@ namespace metaSMT {
         _solver.command ( cmd, expr );
       }
 
+      // commands without arguments the backend supports, e.g. statistics
+      template<typename Command>
+      typename boost::enable_if<
+        features::supports< PredicateSolver, Command >
+      , typename Command::result_type
+      >::type command ( Command const& cmd )
+      {
+        return _solver.command ( cmd );
+      }
+
+      void command ( setup_option_map_cmd const &, Options const & opt )
+      {
+        _opt = opt;
+        configure();
+        typedef typename boost::mpl::if_<
+          /* if   = */ typename features::supports< PredicateSolver, setup_option_map_cmd >::type
+        , /* then = */ option::SetupOptionMapCommand
+        , /* else = */ option::NOPCommand
+        >::type Command;
+        Command::template action( _solver, opt );
+      }
+
+      void command ( set_option_cmd const &, Options const & opt
+          , std::string const & key, std::string const & value )
+      {
+        _opt = opt;
+        configure();
+        typedef typename boost::mpl::if_<
+          /* if   = */ typename features::supports< PredicateSolver, set_option_cmd >::type
+        , /* then = */ option::SetOptionCommand
+        , /* else = */ option::NOPCommand
+        >::type Command;
+        Command::template action( _solver, opt, key, value );
+      }
+
+      GateCacheStatistics command ( gate_cache_statistics_cmd const & )
+      {
+        return _gates.statistics();
+      }
 
     private:
-      result_type sDivRem (result_type arg1, result_type arg2, bool value) {
-  
-        bv_result a = boost::get<bv_result>(arg1);       
-        bv_result b = boost::get<bv_result>(arg2);
-         
-        predtags:: ite_tag ite;
-        predtags:: xor_tag xor_;
-        bvtags:: bvneg_tag neg;
-        
-        result_type tmp1 = (*this)(neg,arg1);
-        result_type tmp2 = (*this)(neg,arg2);
-   
-      
-        result_type aneg = (*this)(ite, a.back(), (*this)(neg,arg1),arg1);
-        result_type bneg = (*this)(ite, b.back(), (*this)(neg,arg2),arg2);
-          
-             
-        result_type test = uDivRem(aneg,bneg,value);
-            
-        test = (*this)(ite, _solver(xor_, a.back(), b.back()), (*this)(neg,test),test);
-        
-        return test;        
-      }  
-      
-    private: 
-      result_type uDivRem (result_type arg1, result_type arg2, bool value) {
-        
-          bv_result a = boost::get<bv_result>(arg1);
-          bv_result b = boost::get<bv_result>(arg2);
-        
-          result_type divisor = arg2 ;
+      /**
+       * reads the BitBlast options:
+       *   bitblast_gate_cache: "1" enables structural hashing of gates
+       *   bitblast_multiplier: "array" (default), "wallace", "dadda" or "booth"
+       *   bitblast_adder: carry network of adders, subtractors and
+       *     comparators, "ripple" (default), "cla", "kogge-stone" or "brent-kung"
+       *   bitblast_array_eager_width: arrays with at most this index width
+       *     (default 8) get their read lemmas eagerly, wider ones lazily
+       *   bitblast_uf_eager_applications: the first applications of each
+       *     uninterpreted function (default 32) get their consistency
+       *     lemmas eagerly, further ones lazily
+       *   bitblast_lazy_arithmetic: "1" bit-blasts multipliers and dividers
+       *     only when a model violates them
+       **/
+      void configure() {
+        _gates.enable( _opt.get("bitblast_gate_cache", "0") == "1" );
+        _multiplier = _opt.get("bitblast_multiplier", "array");
+        if ( _multiplier != "array" && _multiplier != "wallace"
+          && _multiplier != "dadda" && _multiplier != "booth" ) {
+          throw std::invalid_argument("bitblast_multiplier: unknown multiplier \"" + _multiplier + "\"");
+        }
+        _adder = _opt.get("bitblast_adder", "ripple");
+        if ( _adder != "ripple" && _adder != "cla"
+          && _adder != "kogge-stone" && _adder != "brent-kung" ) {
+          throw std::invalid_argument("bitblast_adder: unknown adder \"" + _adder + "\"");
+        }
+        _array_eager_width = boost::lexical_cast<unsigned>(
+          _opt.get("bitblast_array_eager_width", "8") );
+        _uf_eager_applications = boost::lexical_cast<unsigned>(
+          _opt.get("bitblast_uf_eager_applications", "32") );
+        _lazy_arithmetic = _opt.get("bitblast_lazy_arithmetic", "0") == "1";
+      }
 
-          result_base zero = _solver(predtags::false_tag(), boost::any());
-          result_base one = _solver(predtags::true_tag(), boost::any());
-          
-          bv_result ret(a.size(),zero);
-          result_type checker = zero; 
-          predtags::ite_tag ite;
-         /*
-         
-          bvtags:: bvand_tag and_;
-          bvtags:: bvneg_tag neg;
-                   
-        result_type ret1 = (*this)(bvtags::bvuge_tag(), a, ret);
-        result_type ret2 = (*this)(bvtags::bvuge_tag(), b, ret); 
-        result_type ret3 = (*this)(bvtags::bvslt_tag(), a, ret);
-        result_type ret4 = (*this)(bvtags::bvslt_tag(), b, ret);
-                
-       result_type bneg = (*this)(ite, _solver(and_, ret1, ret4), (*this)(bvtags::bvneg_tag(),arg2),b);
-       b = boost::get<bv_result>(bneg);
-       
-       result_type aneg = (*this)(ite, _solver(and_, ret3, ret2), (*this)(bvtags::bvneg_tag(),arg1),a);
-       a = boost::get<bv_result>(aneg);
-        
-        result_type aeg = (*this)(ite, _solver(and_, ret3, ret4), (*this)(bvtags::bvneg_tag(),arg1),a);
-        a = boost::get<bv_result>(aeg);
-        
-        result_type args1 = a;
-        result_type args2 = b; 
-        */  
-           for(unsigned i = 0; i < a.size(); ++i)
-          {
-             result_type tmp = b.back();
-             divisor = (*this)(ite,tmp, divisor, shiftL(b,1));
-             b = boost::get<bv_result>(divisor);
+
+    private:
+      typedef std::pair< bv_result, bv_result > bv_pair;
+
+      struct bv_hash {
+        std::size_t operator() (bv_result const & bv) const {
+          gate_hash<result_base> h;
+          std::size_t seed = 0;
+          BOOST_FOREACH( result_base const & r, bv ) {
+            boost::hash_combine(seed, h(r));
           }
-          
-          for(unsigned i = 1; i <=a.size(); ++i)
-          {
-            result_type bef_dev = divisor;
-            result_type do_devide = (*this)(bvtags::bvuge_tag(), arg1, divisor);
-            result_type eq = (*this)(predtags::equal_tag(),bef_dev,arg2);    
-            
-             arg1 = (*this)(ite, do_devide, (*this)(bvtags::bvsub_tag(), arg1, divisor),arg1);
-       
-        
-            divisor = (*this)(ite, eq, divisor, shiftR(boost::get<bv_result>(divisor), 1, zero));    
-             
-             do_devide = (*this)(ite,checker,zero, do_devide);      
-             ret[a.size()-i] = boost::get<result_base>(do_devide);
-        
-             result_type bo = (*this)(ite,checker,shiftR(ret,1, zero),ret);
-             
-             ret = boost::get<bv_result>(bo);
-             
-             
-             checker = (*this)(ite, eq , one, checker); 
-         } 
-                   
-          if(value)
-          {
-            return ret;
+          return seed;
+        }
+      };
+
+      struct bv_pair_hash {
+        std::size_t operator() (bv_pair const & p) const {
+          std::size_t seed = bv_hash()(p.first);
+          boost::hash_combine(seed, bv_hash()(p.second));
+          return seed;
+        }
+      };
+
+      result_type multiply (bv_result const & a, bv_result const & b) {
+        if ( _multiplier == "wallace" ) {
+          return addColumns( wallaceTree( partialProducts(a, b) ) );
+        }
+        else if ( _multiplier == "dadda" ) {
+          return addColumns( daddaTree( partialProducts(a, b) ) );
+        }
+        else if ( _multiplier == "booth" ) {
+          return addColumns( daddaTree( boothPartialProducts(a, b) ) );
+        }
+        else if ( _multiplier != "array" ) {
+          assert( false && "Unknown multiplier implementation" );
+          throw std::exception();
+        }
+
+        result_type ret = bv_result (a.size(), _gates( predtags::false_tag(), boost::any() ) );
+        result_type tmp1;
+
+        for(unsigned i = 0 ; i < a.size() ; ++i)
+        {
+          tmp1 = (*this)(bvtags::sign_extend_tag(),a.size()-1,bv_result(1,a[i]));
+          tmp1 = (*this)(bvtags::bvand_tag(),b,tmp1);
+          tmp1 = shiftConstant( boost::get<bv_result>(tmp1), i, true
+              , _gates(predtags::false_tag(), boost::any()) );
+
+          ret = (*this)(bvtags::bvadd_tag(),ret,tmp1);
+        }
+        return ret;
+      }
+
+      /**
+       * maps the operands of a divider to quotient and remainder
+       **/
+      typedef std::tr1::unordered_map< bv_pair, bv_pair, bv_pair_hash > DividerCache;
+
+      result_type uDivRem (result_type const & arg1, result_type const & arg2, bool quotient) {
+        bv_result const & a = boost::get<bv_result>(arg1);
+        bv_result const & b = boost::get<bv_result>(arg2);
+        if ( isLazy(a, b) ) {
+          return lazyOperator(quotient ? LAZY_UDIV : LAZY_UREM, a, b);
+        }
+        bv_pair ret = unsignedDivider(a, b);
+        return quotient ? ret.first : ret.second;
+      }
+
+      result_type sDivRem (result_type const & arg1, result_type const & arg2, bool quotient) {
+        bv_result const & a = boost::get<bv_result>(arg1);
+        bv_result const & b = boost::get<bv_result>(arg2);
+        if ( isLazy(a, b) ) {
+          return lazyOperator(quotient ? LAZY_SDIV : LAZY_SREM, a, b);
+        }
+        bv_pair ret = signedDivider(a, b);
+        return quotient ? ret.first : ret.second;
+      }
+
+      /**
+       * quotient and remainder of a restoring array divider: each row
+       * shifts the next bit of a into the partial remainder and subtracts
+       * b unless that borrows. Division by zero yields an all-ones
+       * quotient and a as remainder, the SMT-LIB semantics.
+       * Results are cached on the operand bits, so a/b and a%b share
+       * one divider.
+       **/
+      bv_pair unsignedDivider (bv_result const & a, bv_result const & b) {
+        assert(a.size()==b.size());
+        bv_pair key(a, b);
+        typename DividerCache::const_iterator it = _udividers.find(key);
+        if ( it != _udividers.end() ) {
+          return it->second;
+        }
+
+        const unsigned width = a.size();
+        result_base zero = _gates(predtags::false_tag(), boost::any());
+        result_base one  = _gates(predtags::true_tag(), boost::any());
+        predtags::ite_tag ite;
+
+        bv_result not_b(width);
+        for (unsigned j = 0; j < width; ++j) {
+          not_b[j] = _gates(predtags::not_tag(), b[j]);
+        }
+
+        bv_result q(width);
+        bv_result r(width, zero);
+        for (unsigned i = width; i-- > 0; ) {
+          // (overflow, shifted) = 2*r + a[i]
+          result_base overflow = r.back();
+          bv_result shifted = bv_result::concat(a.slice(i, 1), r.slice(0, width-1));
+
+          // diff = shifted - b, carry is set iff shifted >= b
+          result_base carry;
+          bv_result diff = addWithCarry(shifted, not_b, one, &carry);
+
+          q[i] = _gates(predtags::or_tag(), overflow, carry);
+          bv_result next(width);
+          for (unsigned j = 0; j < width; ++j) {
+            next[j] = _gates(ite, q[i], diff[j], shifted[j]);
           }
-        
-        return arg1; 
-       }
-    
-    
-    
-    
+          r = next;
+        }
+
+        return _udividers[key] = bv_pair(q, r);
+      }
+
+      /**
+       * signed division on the magnitudes of a and b. The quotient is
+       * negative if the signs differ, the remainder takes the sign of a.
+       **/
+      bv_pair signedDivider (bv_result const & a, bv_result const & b) {
+        assert(a.size()==b.size());
+        assert(!a.empty());
+        bv_pair key(a, b);
+        typename DividerCache::const_iterator it = _sdividers.find(key);
+        if ( it != _sdividers.end() ) {
+          return it->second;
+        }
+
+        result_base sign_a = a.back();
+        result_base sign_b = b.back();
+        bv_pair ret = unsignedDivider( negateIf(a, sign_a), negateIf(b, sign_b) );
+        ret.first  = negateIf(ret.first, _gates(predtags::xor_tag(), sign_a, sign_b));
+        ret.second = negateIf(ret.second, sign_a);
+
+        return _sdividers[key] = ret;
+      }
+
+      /**
+       * two's complement negation of a if cond holds: (a ^ cond) + cond
+       **/
+      bv_result negateIf (bv_result const & a, result_base const & cond) {
+        bv_result flipped(a.size());
+        for (unsigned i = 0; i < a.size(); ++i) {
+          flipped[i] = _gates(predtags::xor_tag(), a[i], cond);
+        }
+        bv_result zero(a.size(), _gates(predtags::false_tag(), boost::any()));
+        return addWithCarry(flipped, zero, cond);
+      }
+
     private:
-      result_type shiftR (bv_result a, unsigned value, result_base & x) {
-                
-        //bv_result a = boost::get<bv_result>(arg);
-        bv_result ret(a.size());
-        
-        if(value == 0)
-        {
-          return a;
-        } 
-        
-        for(unsigned i= 0; i < a.size(); ++value,++i)
+      /**
+       * With bitblast_lazy_arithmetic the multipliers and dividers of
+       * two non-constant operands are replaced by fresh result bits and
+       * a few cheap lemmas. After each solve() the model is checked on the
+       * word level and only the operators it violates are bit-blasted,
+       * see refineArithmetic().
+       **/
+      enum LazyKind { LAZY_MUL, LAZY_UDIV, LAZY_UREM, LAZY_SDIV, LAZY_SREM, LAZY_KINDS };
+
+      struct LazyOperator {
+        LazyKind kind;
+        bv_result a;
+        bv_result b;
+        bv_result result;
+        bool blasted;
+      };
+
+      typedef std::tr1::unordered_map< bv_pair, unsigned, bv_pair_hash > LazyCache;
+
+      typedef boost::dynamic_bitset<> word;
+
+      bool isLazy (bv_result const & a, bv_result const & b) const {
+        return _lazy_arithmetic && !isConstant(a) && !isConstant(b);
+      }
+
+      bool isConstant (bv_result const & a) const {
+        BOOST_FOREACH( result_base const & r, a ) {
+          if ( !_gates.is_constant(r) ) return false;
+        }
+        return true;
+      }
+
+      bv_result lazyOperator (LazyKind kind, bv_result const & a, bv_result const & b) {
+        assert(a.size()==b.size());
+        bv_pair key(a, b);
+        typename LazyCache::const_iterator it = _lazy_cache[kind].find(key);
+        if ( it != _lazy_cache[kind].end() ) {
+          return _lazy[it->second].result;
+        }
+
+        LazyOperator op;
+        op.kind = kind;
+        op.a = a;
+        op.b = b;
+        op.result = bv_result(a.size());
+        for (unsigned i = 0; i < a.size(); ++i) {
+          op.result[i] = _gates(predtags::var_tag(), boost::any());
+        }
+        op.blasted = false;
+        lazyLemmas(op);
+
+        _lazy.push_back(op);
+        _lazy_cache[kind].insert( std::make_pair(key, _lazy.size()-1) );
+        return op.result;
+      }
+
+      void lazyLemmas (LazyOperator const & op) {
+        bv_result zero(op.a.size(), _gates(predtags::false_tag(), boost::any()));
+        bv_result ones(op.a.size(), _gates(predtags::true_tag(), boost::any()));
+        result_base b_zero = bvEqual(op.b, zero);
+
+        switch ( op.kind ) {
+          case LAZY_MUL:
+            // the product is odd iff both factors are
+            _solver.assertion( _gates(predtags::equal_tag(), op.result[0]
+              , _gates(predtags::and_tag(), op.a[0], op.b[0])) );
+            // a*0 = 0*b = 0
+            _solver.assertion( _gates(predtags::implies_tag()
+              , _gates(predtags::or_tag(), bvEqual(op.a, zero), b_zero)
+              , bvEqual(op.result, zero)) );
+            break;
+          case LAZY_UDIV:
+            _solver.assertion( _gates(predtags::implies_tag(), b_zero, bvEqual(op.result, ones)) );
+            break;
+          case LAZY_UREM:
+            _solver.assertion( _gates(predtags::implies_tag(), b_zero, bvEqual(op.result, op.a)) );
+            break;
+          default:
+            break;
+        }
+      }
+
+      bv_result blast (LazyOperator const & op) {
+        switch ( op.kind ) {
+          case LAZY_MUL:  return boost::get<bv_result>( multiply(op.a, op.b) );
+          case LAZY_UDIV: return unsignedDivider(op.a, op.b).first;
+          case LAZY_UREM: return unsignedDivider(op.a, op.b).second;
+          case LAZY_SDIV: return signedDivider(op.a, op.b).first;
+          case LAZY_SREM: return signedDivider(op.a, op.b).second;
+          default:
+            assert( false && "Unknown lazy operator" );
+            throw std::exception();
+        }
+      }
+
+      /**
+       * bit-blasts the lazy operators whose result in the current model
+       * differs from the word level result of their operands.
+       * Returns true if an operator was blasted.
+       **/
+      bool refineArithmetic () {
+        bool refined = false;
+        for (unsigned i = 0; i < _lazy.size(); ++i) {
+          if ( _lazy[i].blasted ) continue;
+          LazyOperator const op = _lazy[i];
+
+          word a, b, result;
+          if ( modelWord(op.a, a) && modelWord(op.b, b)
+            && modelWord(op.result, result) && evaluateWord(op.kind, a, b) == result ) {
+            continue;
+          }
+
+          _lazy[i].blasted = true;
+          _solver.assertion( bvEqual(op.result, blast(op)) );
+          refined = true;
+        }
+        return refined;
+      }
+
+      /**
+       * the value of bv in the current model, false if a bit is unknown
+       **/
+      bool modelWord (bv_result const & bv, word & w) {
+        w.resize(bv.size());
+        for (unsigned i = 0; i < bv.size(); ++i) {
+          boost::logic::tribool bit = read_value(bv[i]);
+          if ( boost::logic::indeterminate(bit) ) return false;
+          w[i] = bit;
+        }
+        return true;
+      }
+
+      /**
+       * word level evaluation with the semantics of the bit-blasted
+       * multiplier and dividers
+       **/
+      static word evaluateWord (LazyKind kind, word const & a, word const & b) {
+        word q, r;
+        switch ( kind ) {
+          case LAZY_MUL:
+            return wordMul(a, b);
+          case LAZY_UDIV:
+          case LAZY_UREM:
+            wordDivRem(a, b, q, r);
+            return kind == LAZY_UDIV ? q : r;
+          default:
+            break;
+        }
+
+        const bool sign_a = a[a.size()-1];
+        const bool sign_b = b[b.size()-1];
+        wordDivRem( sign_a ? wordNeg(a) : a, sign_b ? wordNeg(b) : b, q, r);
+        if ( kind == LAZY_SDIV ) {
+          return sign_a != sign_b ? wordNeg(q) : q;
+        }
+        return sign_a ? wordNeg(r) : r;
+      }
+
+      static word wordAdd (word const & a, word const & b) {
+        word sum(a.size());
+        bool carry = false;
+        for (unsigned i = 0; i < a.size(); ++i) {
+          sum[i] = a[i] ^ b[i] ^ carry;
+          carry = (a[i] && b[i]) || (carry && (a[i] ^ b[i]));
+        }
+        return sum;
+      }
+
+      static word wordNeg (word const & a) {
+        return wordAdd(~a, word(a.size(), 1));
+      }
+
+      static word wordMul (word const & a, word const & b) {
+        word product(a.size());
+        for (unsigned i = 0; i < b.size(); ++i) {
+          if ( b[i] ) product = wordAdd(product, a << i);
+        }
+        return product;
+      }
+
+      static bool wordUle (word const & a, word const & b) {
+        for (unsigned i = a.size(); i-- > 0; ) {
+          if ( a[i] != b[i] ) return b[i];
+        }
+        return true;
+      }
+
+      static void wordDivRem (word const & a, word const & b, word & q, word & r) {
+        const unsigned width = a.size();
+        q = word(width);
+        r = word(width);
+        if ( b.none() ) {
+          q.set();
+          r = a;
+          return;
+        }
+        for (unsigned i = width; i-- > 0; ) {
+          const bool overflow = r[width-1];
+          r <<= 1;
+          r[0] = a[i];
+          if ( overflow || wordUle(b, r) ) {
+            r = wordAdd(r, wordNeg(b));
+            q[i] = true;
+          }
+        }
+      }
+
+    private:
+      /**
+       * Arrays are eliminated by reads of the base array variables: a
+       * select walks the stores of its array term and ends in a read of
+       * the base array, a fresh bit-vector per distinct index. Reads of the
+       * same base are consistent if equal indices give equal elements.
+       * These (Ackermann) lemmas are asserted eagerly for arrays with an
+       * index width up to bitblast_array_eager_width, and otherwise only
+       * when a model violates them, see refineArrays().
+       **/
+      struct ArrayRead {
+        bv_result index;
+        bv_result value;
+      };
+
+      typedef std::tr1::unordered_map< bv_result, unsigned, bv_hash > ReadCache;
+
+      struct ArrayBase {
+        ArrayBase() : function(false) {}
+
+        unsigned elem_width;
+        unsigned index_width;
+        // the base of an uninterpreted function
+        bool function;
+        std::vector< ArrayRead > reads;
+        ReadCache read_cache;
+        // pairs of reads that already have their lemma
+        std::set< std::pair<unsigned, unsigned> > lemmas;
+      };
+
+      /**
+       * predicate p of a == b. p false is encoded with a fresh index k
+       * and a[k] != b[k], p true is refined lazily on the indices used
+       * with a or b.
+       **/
+      struct ArrayEquality {
+        result_base p;
+        array_result a;
+        array_result b;
+        std::vector< bv_result > refined;
+      };
+
+      bv_result select (array_result const & a, bv_result const & index) {
+        if ( index.size() != _arrays[a.base].index_width ) {
+          throw std::invalid_argument("select: index width does not match the array");
+        }
+        // newest store first, stop at a store that is known to be hit
+        std::vector< array_store const * > stores;
+        std::vector< result_base > hits;
+        bv_result ret;
+        for (array_store const * st = a.stores.get(); st; st = st->next.get()) {
+          result_base hit = bvEqual(index, st->index);
+          if ( _gates.is_true(hit) ) {
+            ret = st->value;
+            break;
+          }
+          if ( !_gates.is_false(hit) ) {
+            stores.push_back(st);
+            hits.push_back(hit);
+          }
+        }
+        if ( ret.empty() ) {
+          ret = baseRead(a.base, index);
+        }
+
+        predtags::ite_tag ite;
+        for (unsigned i = stores.size(); i-- > 0; ) {
+          bv_result next(ret.size());
+          for (unsigned j = 0; j < ret.size(); ++j) {
+            next[j] = _gates(ite, hits[i], stores[i]->value[j], ret[j]);
+          }
+          ret = next;
+        }
+        return ret;
+      }
+
+      bv_result baseRead (unsigned base, bv_result const & index) {
+        ArrayBase & arr = _arrays[base];
+        typename ReadCache::const_iterator it = arr.read_cache.find(index);
+        if ( it != arr.read_cache.end() ) {
+          return arr.reads[it->second].value;
+        }
+
+        ArrayRead read;
+        read.index = index;
+        read.value = bv_result(arr.elem_width);
+        for (unsigned i = 0; i < arr.elem_width; ++i) {
+          read.value[i] = _gates(predtags::var_tag(), boost::any());
+        }
+        arr.reads.push_back(read);
+        const unsigned r = arr.reads.size()-1;
+        arr.read_cache.insert( std::make_pair(index, r) );
+
+        const bool eager = arr.function
+          ? r < _uf_eager_applications
+          : arr.index_width <= _array_eager_width;
+        if ( eager ) {
+          for (unsigned i = 0; i < r; ++i) {
+            readLemma(base, i, r);
+          }
+        }
+        return read.value;
+      }
+
+      struct Function {
+        unsigned base;
+        bool boolean;
+        std::vector< unsigned > arg_widths;
+      };
+
+      static unsigned typeWidth (type::any_type const & t) {
+        if ( type::BitVector const * bv = boost::get<type::BitVector>(&t) ) {
+          return bv->width;
+        }
+        if ( boost::get<type::Boolean>(&t) ) {
+          return 1;
+        }
+        throw std::invalid_argument("uninterpreted functions over arrays are not supported");
+      }
+
+      result_type apply (result_type const & func, std::vector< result_type > const & args) {
+        Function const & f = _functions[ boost::get<function_result>(func).id ];
+        if ( args.size() != f.arg_widths.size() ) {
+          throw std::invalid_argument("application: wrong number of arguments");
+        }
+        // the first argument in the least significant bits
+        bv_result index;
+        for (unsigned i = 0; i < args.size(); ++i) {
+          bv_result arg;
+          if ( result_base const * b = boost::get<result_base>(&args[i]) ) {
+            arg = bv_result(1, *b);
+          } else {
+            arg = boost::get<bv_result>(args[i]);
+          }
+          if ( arg.size() != f.arg_widths[i] ) {
+            throw std::invalid_argument("application: argument width does not match the function");
+          }
+          index = bv_result::concat(index, arg);
+        }
+
+        bv_result value = baseRead(f.base, index);
+        if ( f.boolean ) {
+          return value[0];
+        }
+        return value;
+      }
+
+      /**
+       * asserts index_i == index_j -> value_i == value_j
+       **/
+      void readLemma (unsigned base, unsigned i, unsigned j) {
+        ArrayBase & arr = _arrays[base];
+        if ( !arr.lemmas.insert( std::make_pair(i, j) ).second ) return;
+        ArrayRead const & ri = arr.reads[i];
+        ArrayRead const & rj = arr.reads[j];
+        _solver.assertion( _gates(predtags::implies_tag()
+          , bvEqual(ri.index, rj.index), bvEqual(ri.value, rj.value)) );
+      }
+
+      result_base arrayEqual (array_result const & a, array_result const & b) {
+        if ( _arrays[a.base].index_width != _arrays[b.base].index_width
+          || _arrays[a.base].elem_width != _arrays[b.base].elem_width ) {
+          throw std::invalid_argument("equal: arrays of different widths");
+        }
+        if ( a.base == b.base && a.stores == b.stores ) {
+          return _gates(predtags::true_tag(), boost::any());
+        }
+
+        ArrayEquality eq;
+        eq.p = _gates(predtags::var_tag(), boost::any());
+        eq.a = a;
+        eq.b = b;
+
+        // !p -> a[k] != b[k]
+        bv_result k(_arrays[a.base].index_width);
+        for (unsigned i = 0; i < k.size(); ++i) {
+          k[i] = _gates(predtags::var_tag(), boost::any());
+        }
+        _solver.assertion( _gates(predtags::or_tag(), eq.p
+          , _gates(predtags::not_tag(), bvEqual( select(a, k), select(b, k) ))) );
+
+        _array_equalities.push_back(eq);
+        return eq.p;
+      }
+
+      result_base bvEqual (bv_result const & a, bv_result const & b) {
+        if ( a == b ) {
+          return _gates(predtags::true_tag(), boost::any());
+        }
+        return boost::get<result_base>( (*this)(predtags::equal_tag(), a, b) );
+      }
+
+      std::string modelValue (bv_result const & bv) {
+        return read_value(bv);
+      }
+
+      /**
+       * checks the current model against the array axioms and asserts
+       * the lemmas it violates:
+       *  - reads of the same base with equal index values but different
+       *    elements get their read lemma, this includes the applications
+       *    of uninterpreted functions
+       *  - each true array equality p of a and b gets p -> a[j] == b[j]
+       *    for the indices j used with a or b where the model disagrees
+       *    or does not know the element.
+       * Each lemma is added at most once, so the refinement terminates.
+       * Returns true if a lemma was added.
+       **/
+      bool refine () {
+        // both refinements look at the same model
+        const bool arrays = refineArrays();
+        const bool arithmetic = refineArithmetic();
+        return arrays || arithmetic;
+      }
+
+      bool refineArrays () {
+        bool refined = false;
+
+        // index value -> element value, per base
+        std::vector< std::map<std::string, std::string> > memory(_arrays.size());
+        for (unsigned b = 0; b < _arrays.size(); ++b) {
+          std::map<std::string, unsigned> first;
+          const unsigned reads = _arrays[b].reads.size();
+          for (unsigned r = 0; r < reads; ++r) {
+            ArrayRead const & read = _arrays[b].reads[r];
+            const std::string index = modelValue(read.index);
+            const std::string value = modelValue(read.value);
+            std::map<std::string, unsigned>::const_iterator it = first.find(index);
+            if ( it == first.end() ) {
+              first.insert( std::make_pair(index, r) );
+              memory[b][index] = value;
+            } else if ( memory[b][index] != value
+                && _arrays[b].lemmas.count( std::make_pair(it->second, r) ) == 0 ) {
+              readLemma(b, it->second, r);
+              refined = true;
+            }
+          }
+        }
+
+        for (unsigned e = 0; e < _array_equalities.size(); ++e) {
+          boost::logic::tribool holds = read_value(_array_equalities[e].p);
+          if ( !holds ) continue;
+          ArrayEquality eq = _array_equalities[e];
+
+          std::vector< bv_result > indices;
+          collectIndices(eq.a, indices);
+          collectIndices(eq.b, indices);
+          BOOST_FOREACH( bv_result const & j, indices ) {
+            if ( std::find(eq.refined.begin(), eq.refined.end(), j) != eq.refined.end() ) {
+              continue;
+            }
+            std::string va, vb;
+            const bool known = modelSelect(eq.a, j, memory, va)
+              && modelSelect(eq.b, j, memory, vb);
+            if ( known && va == vb ) continue;
+
+            _array_equalities[e].refined.push_back(j);
+            _solver.assertion( _gates(predtags::implies_tag(), eq.p
+              , bvEqual( select(eq.a, j), select(eq.b, j) )) );
+            refined = true;
+          }
+        }
+        return refined;
+      }
+
+      void collectIndices (array_result const & a, std::vector< bv_result > & indices) {
+        for (array_store const * st = a.stores.get(); st; st = st->next.get()) {
+          indices.push_back(st->index);
+        }
+        BOOST_FOREACH( ArrayRead const & read, _arrays[a.base].reads ) {
+          indices.push_back(read.index);
+        }
+      }
+
+      /**
+       * the element of a at index j in the current model, false if the
+       * base array was never read at that index.
+       **/
+      bool modelSelect (array_result const & a, bv_result const & j
+          , std::vector< std::map<std::string, std::string> > const & memory
+          , std::string & value )
+      {
+        const std::string index = modelValue(j);
+        for (array_store const * st = a.stores.get(); st; st = st->next.get()) {
+          if ( modelValue(st->index) == index ) {
+            value = modelValue(st->value);
+            return true;
+          }
+        }
+        std::map<std::string, std::string>::const_iterator it = memory[a.base].find(index);
+        if ( it == memory[a.base].end() ) {
+          return false;
+        }
+        value = it->second;
+        return true;
+      }
+
+    private:
+      /**
+       * bits of equal weight, column i holds the bits of weight 2^i
+       **/
+      typedef std::vector< bits_type > columns_type;
+
+      void halfAdder (result_base const & a, result_base const & b
+          , result_base & sum, result_base & carry)
+      {
+        sum   = _gates(predtags::xor_tag(), a, b);
+        carry = _gates(predtags::and_tag(), a, b);
+      }
+
+      void fullAdder (result_base const & a, result_base const & b, result_base const & c
+          , result_base & sum, result_base & carry)
+      {
+        result_base ab = _gates(predtags::xor_tag(), a, b);
+        sum   = _gates(predtags::xor_tag(), ab, c);
+        // c if a and b differ, otherwise a (== b)
+        carry = _gates(predtags::ite_tag(), ab, c, a);
+      }
+
+      /**
+       * and-array of partial products, truncated to the width of a
+       **/
+      columns_type partialProducts (bv_result const & a, bv_result const & b) {
+        const unsigned width = a.size();
+        columns_type cols(width);
+        for (unsigned i = 0; i < width; ++i) {
+          for (unsigned j = 0; i+j < width; ++j) {
+            cols[i+j].push_back( _gates(predtags::and_tag(), a[j], b[i]) );
+          }
+        }
+        return cols;
+      }
+
+      /**
+       * radix-4 Booth recoding: b is split into overlapping triples
+       * (b[2k+1], b[2k], b[2k-1]) selecting 0, +-a or +-2a. Negative rows
+       * are inverted and get the +1 in their lowest column. Since the
+       * product is truncated to the width of a, b is sign extended.
+       **/
+      columns_type boothPartialProducts (bv_result const & a, bv_result const & b) {
+        const unsigned width = a.size();
+        columns_type cols(width);
+        result_base zero = _gates(predtags::false_tag(), boost::any());
+        predtags::and_tag and_;
+        predtags::or_tag or_;
+        predtags::not_tag not_;
+
+        for (unsigned k = 0; 2*k < width; ++k) {
+          result_base lo  = k == 0 ? zero : b[2*k-1];
+          result_base mid = b[2*k];
+          result_base hi  = 2*k+1 < width ? b[2*k+1] : b.back();
+
+          result_base one = _gates(predtags::xor_tag(), mid, lo);
+          result_base two = _gates(or_
+            , _gates(and_, hi, _gates(and_, _gates(not_, mid), _gates(not_, lo)))
+            , _gates(and_, _gates(not_, hi), _gates(and_, mid, lo)));
+
+          for (unsigned j = 0; 2*k+j < width; ++j) {
+            result_base sel = _gates(or_
+              , _gates(and_, one, a[j])
+              , _gates(and_, two, j > 0 ? a[j-1] : zero));
+            cols[2*k+j].push_back( _gates(predtags::xor_tag(), sel, hi) );
+          }
+          cols[2*k].push_back(hi);
+        }
+        return cols;
+      }
+
+      /**
+       * Wallace tree: every stage compresses each column with as many
+       * full and half adders as possible until at most two rows remain.
+       * Carries out of the top column are dropped.
+       **/
+      columns_type wallaceTree (columns_type cols) {
+        const unsigned width = cols.size();
+        bool reduce = true;
+        while ( reduce ) {
+          reduce = false;
+          columns_type next(width);
+          for (unsigned i = 0; i < width; ++i) {
+            bits_type const & col = cols[i];
+            unsigned k = 0;
+            result_base sum, carry;
+            for ( ; k+3 <= col.size(); k += 3) {
+              fullAdder(col[k], col[k+1], col[k+2], sum, carry);
+              next[i].push_back(sum);
+              if ( i+1 < width ) next[i+1].push_back(carry);
+            }
+            if ( k+2 == col.size() && col.size() > 2 ) {
+              halfAdder(col[k], col[k+1], sum, carry);
+              next[i].push_back(sum);
+              if ( i+1 < width ) next[i+1].push_back(carry);
+              k += 2;
+            }
+            next[i].insert(next[i].end(), col.begin()+k, col.end());
+          }
+          std::swap(cols, next);
+          for (unsigned i = 0; i < width; ++i) {
+            reduce = reduce || cols[i].size() > 2;
+          }
+        }
+        return cols;
+      }
+
+      /**
+       * Dadda tree: the column heights are reduced stage by stage to the
+       * sequence 2, 3, 4, 6, 9, ... using only as many adders as needed.
+       **/
+      columns_type daddaTree (columns_type cols) {
+        const unsigned width = cols.size();
+        unsigned max_height = 0;
+        for (unsigned i = 0; i < width; ++i) {
+          max_height = std::max<unsigned>(max_height, cols[i].size());
+        }
+
+        std::vector<unsigned> heights(1, 2);
+        while ( heights.back() < max_height ) {
+          heights.push_back( heights.back() * 3 / 2 );
+        }
+        heights.pop_back();
+
+        for (unsigned stage = heights.size(); stage > 0; --stage) {
+          const unsigned d = heights[stage-1];
+          for (unsigned i = 0; i < width; ++i) {
+            bits_type & col = cols[i];
+            unsigned k = 0;
+            result_base sum, carry;
+            while ( col.size() - k > d ) {
+              if ( col.size() - k == d+1 ) {
+                halfAdder(col[k], col[k+1], sum, carry);
+                k += 2;
+              } else {
+                fullAdder(col[k], col[k+1], col[k+2], sum, carry);
+                k += 3;
+              }
+              col.push_back(sum);
+              if ( i+1 < width ) cols[i+1].push_back(carry);
+            }
+            col.erase(col.begin(), col.begin()+k);
+          }
+        }
+        return cols;
+      }
+
+      /**
+       * adds the (at most two) rows left in the columns
+       **/
+      result_type addColumns (columns_type const & cols) {
+        const unsigned width = cols.size();
+        result_base zero = _gates(predtags::false_tag(), boost::any());
+        bv_result row0(width, zero);
+        bv_result row1(width, zero);
+        for (unsigned i = 0; i < width; ++i) {
+          assert(cols[i].size() <= 2);
+          if ( cols[i].size() > 0 ) row0[i] = cols[i][0];
+          if ( cols[i].size() > 1 ) row1[i] = cols[i][1];
+        }
+        return (*this)(bvtags::bvadd_tag(), row0, row1);
+      }
+
+    private:
+      /**
+       * Carries are computed as prefixes over positions 0..n-1 from the
+       * least significant bit upwards. Each position has a generate bit g
+       * and a decided bit d: if d is set the position produces carry g,
+       * otherwise it passes on the carry from below. Position 0 is the
+       * carry in and always decided. A range of positions combines as
+       *   (g, d) = (ite(d_hi, g_hi, g_lo), d_hi | d_lo)
+       * and g only matters where d is set, so for an adder g can be
+       * either operand bit and for a comparator simply the bit of b.
+       **/
+      void combine (result_base & g_hi, result_base & d_hi
+          , result_base const & g_lo, result_base const & d_lo)
+      {
+        g_hi = _gates(predtags::ite_tag(), d_hi, g_hi, g_lo);
+        d_hi = _gates(predtags::or_tag(), d_hi, d_lo);
+      }
+
+      /**
+       * folds the low positions as long as their carries stay constant,
+       * e.g. when adding a constant. A network would build cells for
+       * them, because its ranges only see the carry in at the end.
+       * Returns the last folded position.
+       **/
+      unsigned foldConstantCarries (bits_type & g, bits_type & d) {
+        result_base one  = _gates(predtags::true_tag(), boost::any());
+        result_base zero = _gates(predtags::false_tag(), boost::any());
+        unsigned k = 0;
+        while ( k+1 < g.size() && _gates.is_constant(g[k]) ) {
+          result_base const & carry = g[k];
+          const bool folds = g[k+1] == carry
+            || d[k+1] == zero
+            || ( d[k+1] == one && _gates.is_constant(g[k+1]) )
+            || ( d[k+1] == g[k+1] && carry == one );
+          if ( !folds ) break;
+          combine(g[k+1], d[k+1], g[k], d[k]);
+          ++k;
+        }
+        return k;
+      }
+
+      /**
+       * turns g into the carries, g[i] afterwards is the carry into
+       * position i.
+       **/
+      void prefixCarries (bits_type & g, bits_type & d) {
+        const unsigned k = foldConstantCarries(g, d);
+        bits_type tail_g(g.begin()+k, g.end());
+        bits_type tail_d(d.begin()+k, d.end());
+        prefixNetwork(tail_g, tail_d);
+        std::copy(tail_g.begin(), tail_g.end(), g.begin()+k);
+      }
+
+      /**
+       * the prefix network selected by bitblast_adder:
+       *   ripple:      a chain, n-1 cells and depth n-1
+       *   cla:         lookahead inside blocks of four, the block
+       *                carries ripple
+       *   kogge-stone: depth log2(n), about n*log2(n) cells
+       *   brent-kung:  depth 2*log2(n), about 2*n cells
+       * Ranges that reach position 0 are decided, the cells on them
+       * fold to a single ite.
+       **/
+      void prefixNetwork (bits_type & g, bits_type & d) {
+        const unsigned n = g.size();
+        if ( _adder == "ripple" ) {
+          for (unsigned i = 1; i < n; ++i) {
+            combine(g[i], d[i], g[i-1], d[i-1]);
+          }
+        }
+        else if ( _adder == "cla" ) {
+          for (unsigned lo = 1; lo < n; lo += 4) {
+            const unsigned hi = std::min(lo+4, n);
+            // lookahead inside the block, independent of its carry in
+            for (unsigned i = lo+1; i < hi; ++i) {
+              combine(g[i], d[i], g[i-1], d[i-1]);
+            }
+            for (unsigned i = lo; i < hi; ++i) {
+              combine(g[i], d[i], g[lo-1], d[lo-1]);
+            }
+          }
+        }
+        else if ( _adder == "kogge-stone" ) {
+          for (unsigned s = 1; s < n; s *= 2) {
+            for (unsigned i = n; i-- > s; ) {
+              combine(g[i], d[i], g[i-s], d[i-s]);
+            }
+          }
+        }
+        else if ( _adder == "brent-kung" ) {
+          unsigned top = 1;
+          for (unsigned s = 1; s < n; s *= 2) {
+            for (unsigned i = 2*s-1; i < n; i += 2*s) {
+              combine(g[i], d[i], g[i-s], d[i-s]);
+            }
+            if ( 2*s < n ) top = 2*s;
+          }
+          for (unsigned s = top/2; s > 0; s /= 2) {
+            for (unsigned i = 3*s-1; i < n; i += 2*s) {
+              combine(g[i], d[i], g[i-s], d[i-s]);
+            }
+          }
+        }
+        else {
+          assert( false && "Unknown adder implementation" );
+          throw std::exception();
+        }
+      }
+
+      /**
+       * the carry out of all positions, without the intermediate carries
+       * a full prefix network would compute.
+       **/
+      result_base carryOut (bits_type g, bits_type d) {
+        const unsigned k = foldConstantCarries(g, d);
+        g.erase(g.begin(), g.begin()+k);
+        d.erase(d.begin(), d.begin()+k);
+
+        if ( _adder == "ripple" ) {
+          prefixNetwork(g, d);
+          return g.back();
+        }
+        else if ( _adder == "cla" ) {
+          result_base carry = g[0];
+          for (unsigned lo = 1; lo < g.size(); lo += 4) {
+            const unsigned hi = std::min<unsigned>(lo+4, g.size());
+            // lookahead of the whole block, then one cell for its carry in
+            for (unsigned i = lo+1; i < hi; ++i) {
+              combine(g[i], d[i], g[i-1], d[i-1]);
+            }
+            combine(g[hi-1], d[hi-1], carry, d[0]);
+            carry = g[hi-1];
+          }
+          return carry;
+        }
+        else if ( _adder != "kogge-stone" && _adder != "brent-kung" ) {
+          assert( false && "Unknown adder implementation" );
+          throw std::exception();
+        }
+
+        // both trees reduce to a balanced tree of cells
+        while ( g.size() > 1 ) {
+          const unsigned n = g.size();
+          for (unsigned i = 0; i+1 < n; i += 2) {
+            combine(g[i+1], d[i+1], g[i], d[i]);
+            g[i/2] = g[i+1];
+            d[i/2] = d[i+1];
+          }
+          if ( n % 2 ) {
+            g[n/2] = g[n-1];
+            d[n/2] = d[n-1];
+          }
+          g.resize( (n+1)/2 );
+          d.resize( (n+1)/2 );
+        }
+        return g[0];
+      }
+
+      /**
+       * x + y + cin with the carry network selected by bitblast_adder.
+       * If carry is given it receives the carry out of the msb.
+       **/
+      bv_result addWithCarry (bv_result const & x, bv_result const & y
+          , result_base const & cin, result_base * carry = 0)
+      {
+        assert(x.size()==y.size());
+        const unsigned width = x.size();
+        const unsigned n = carry ? width+1 : width;
+        gate_hash<result_base> h;
+
+        bits_type equal(width);
+        for (unsigned i = 0; i < width; ++i) {
+          equal[i] = _gates(predtags::xnor_tag(), x[i], y[i]);
+        }
+
+        bits_type g(n), d(n);
+        g[0] = cin;
+        d[0] = _gates(predtags::true_tag(), boost::any());
+        for (unsigned i = 0; i+1 < n; ++i) {
+          // a bit is decided if x[i] == y[i]. Prefer a constant operand,
+          // otherwise use the smaller hash so x + y and y + x share gates.
+          bool take_x = _gates.is_constant(x[i])
+            || ( !_gates.is_constant(y[i]) && h(x[i]) < h(y[i]) );
+          g[i+1] = take_x ? x[i] : y[i];
+          d[i+1] = equal[i];
+        }
+
+        prefixCarries(g, d);
+
+        bv_result ret(width);
+        for (unsigned i = 0; i < width; ++i) {
+          ret[i] = _gates(predtags::xnor_tag(), equal[i], g[i]);
+        }
+        if ( carry ) {
+          *carry = g[width];
+        }
+        return ret;
+      }
+
+      /**
+       * a < b (or a <= b if or_equal) on the carry network of the adder:
+       * the highest differing bit decides, with b[i] as generate bit.
+       * For signed comparison the sign bits decide the other way round.
+       **/
+      result_base lessThan (bv_result const & a, bv_result const & b, bool or_equal, bool is_signed) {
+        assert(a.size()==b.size());
+        assert(a.size()>0);
+        const unsigned width = a.size();
+
+        bits_type g(width+1), d(width+1);
+        g[0] = or_equal
+          ? _gates(predtags::true_tag(), boost::any())
+          : _gates(predtags::false_tag(), boost::any());
+        d[0] = _gates(predtags::true_tag(), boost::any());
+        for (unsigned i = 0; i < width; ++i) {
+          g[i+1] = b[i];
+          d[i+1] = _gates(predtags::xor_tag(), a[i], b[i]);
+        }
+        if ( is_signed ) {
+          g[width] = a[width-1];
+        }
+        return carryOut(g, d);
+      }
+
+    private:
+      /**
+       * logarithmic barrel shifter: stage i shifts by 2^i if bit i of
+       * amount is set. Bits of amount whose stage would shift everything
+       * out are or-ed together and saturate the result to fill.
+       **/
+      result_type barrelShift (bv_result a, bv_result const & amount, bool left, result_base fill) {
+        predtags::ite_tag ite;
+        const unsigned width = a.size();
+
+        // shifting by a constant only rewires the bits
+        unsigned long distance = 0;
+        bool constant = true;
+        result_base one = _gates(predtags::true_tag(), boost::any());
+        for (unsigned i = 0; i < amount.size() && constant; ++i) {
+          constant = _gates.is_constant(amount[i]);
+          if ( constant && amount[i] == one ) {
+            distance = i < sizeof(unsigned long)*8-1
+              ? distance | (1ul << i)
+              : width;
+          }
+        }
+        if ( constant ) {
+          return shiftConstant(a, std::min<unsigned long>(distance, width), left, fill);
+        }
+
+        // the bits of amount that shift everything out
+        std::vector<result_base> overflow;
+
+        for(unsigned i = 0; i < amount.size(); ++i)
         {
-          if(value < a.size())
+          if ( i >= sizeof(unsigned)*8-1 || (1u << i) >= width ) {
+            overflow.push_back( amount[i] );
+            continue;
+          }
+
+          const unsigned dist = 1u << i;
+          bv_result ret(width);
+          for(unsigned j = 0; j < width; ++j)
           {
-            ret[i] = a[value];
-          } else
-            ret[i] = x;
-        }
-       return ret; 
-      } 
-
-   private:
-      result_type shiftL (bv_result a, unsigned value) {
-                
-        //bv_result a = boost::get<bv_result>(arg);
-        bv_result ret(a.size());
-        
-        if(value == 0)
-        {
-          return a;
-        } 
-        
-        for(unsigned i= 0; i < a.size(); ++i)
-        {
-          if( i < value)
+            result_base shifted;
+            if ( left ) {
+              shifted = j >= dist ? a[j-dist] : fill;
+            } else {
+              shifted = j+dist < width ? a[j+dist] : fill;
+            }
+            ret[j] = _gates(ite, amount[i], shifted, a[j]);
+          }
+          a = ret;
+        }
+
+        if ( !overflow.empty() ) {
+          result_base any = overflow[0];
+          for(unsigned i = 1; i < overflow.size(); ++i)
+          {
+            any = _gates(predtags::or_tag(), any, overflow[i]);
+          }
+          bv_result ret(width);
+          for(unsigned j = 0; j < width; ++j)
           {
-             ret[i] = _solver(predtags::false_tag(),boost::any());
-          } else
-             ret[i] = a[i-value];
+            ret[j] = _gates(ite, any, fill, a[j]);
+          }
+          a = ret;
         }
-       return ret; 
-      } 
+        return a;
+      }
+
+      /**
+       * a shifted by a constant distance, a slice of a and fill bits
+       **/
+      bv_result shiftConstant (bv_result const & a, unsigned long distance, bool left, result_base const & fill) {
+        const unsigned long width = a.size();
+        assert(distance <= width);
+        bv_result filled(distance, fill);
+        if ( left ) {
+          return bv_result::concat(filled, a.slice(0, width-distance));
+        } else {
+          return bv_result::concat(a.slice(distance, width-distance), filled);
+        }
+      }
 
     private:
         PredicateSolver _solver;
+        GateCache<PredicateSolver> _gates;
+        Options _opt;
+        std::string _multiplier;
+        std::string _adder;
+        unsigned _array_eager_width;
+        std::vector< ArrayBase > _arrays;
+        std::vector< ArrayEquality > _array_equalities;
+        unsigned _uf_eager_applications;
+        std::vector< Function > _functions;
+        bool _lazy_arithmetic;
+        std::vector< LazyOperator > _lazy;
+        LazyCache _lazy_cache[LAZY_KINDS];
+        std::vector< result_base > _assumptions;
+        DividerCache _udividers;
+        DividerCache _sdividers;
 
   };
 
@@ -1145,6 +2096,18 @@ namespace metaSMT {
     struct supports< BitBlast<Context>, features::addclause_api>
     : boost::mpl::true_ {};
 
+    template<typename Context>
+    struct supports< BitBlast<Context>, setup_option_map_cmd>
+    : boost::mpl::true_ {};
+
+    template<typename Context>
+    struct supports< BitBlast<Context>, set_option_cmd>
+    : boost::mpl::true_ {};
+
+    template<typename Context>
+    struct supports< BitBlast<Context>, gate_cache_statistics_cmd>
+    : boost::mpl::true_ {};
+
     /* Forward all other supported operations */
     template<typename Context, typename Feature>
     struct supports< BitBlast<Context>, Feature>
@@ -41,7 +41,14 @@ namespace metaSMT {
 
     DirectSolver_Context(Options const &opt)
       : opt(opt)
-    {}
+    {
+      typedef typename boost::mpl::if_<
+        /* if   = */ typename features::supports< SolverContext, setup_option_map_cmd >::type
+      , /* then = */ option::SetupOptionMapCommand
+      , /* else = */ option::NOPCommand
+      >::type Command;
+      Command::template action( static_cast<SolverContext&>(*this), this->opt );
+    }
 
     /// The returned expression type is the result_type of the SolverContext
     typedef typename SolverContext::result_type result_type;
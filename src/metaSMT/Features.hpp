@@ -13,6 +13,22 @@ namespace metaSMT {
    **/
   template <typename Context, typename Feature>
   struct supports : boost::mpl::false_ {};
+
+  /**
+   * Contexts whose copies are independent solvers in which the results
+   * of the original stay valid, e.g. because they share an immutable
+   * node manager. GraphSolver_Context copies such solvers instead of
+   * translating the assertions again. Unlike supports this is not
+   * forwarded by wrapping contexts.
+   **/
+  template <typename Context>
+  struct copyable_results : boost::mpl::false_ {};
+
+  /**
+   * Feature of solvers that keep global state, so only one instance
+   * may be used at a time (e.g. PicoSAT).
+   **/
+  struct single_instance;
   
   } /* features */
 } /* metaSMT */
@@ -8,39 +8,48 @@
 #include "API/Assertion.hpp"
 #include "API/Assumption.hpp"
 #include "API/Options.hpp"
+#include "API/CollectGarbage.hpp"
 
 #include <boost/foreach.hpp>
+#include <boost/optional.hpp>
 #include <boost/shared_ptr.hpp>
-#include <boost/spirit/include/phoenix_core.hpp>
-#include <boost/spirit/include/phoenix_bind.hpp>
+#include <boost/function.hpp>
 
+#include <algorithm>
+#include <map>
+#include <stdexcept>
 #include <vector>
 
 namespace metaSMT {
 
+  /**
+   * calls callee with a tag, the results of its inputs and the
+   * parameters of the node (arg). args points to arity pointers to the
+   * input results.
+   **/
   template <typename Callee, typename T>
   struct CallByTag {
-    CallByTag(Callee * callee, std::vector<T> const & args, boost::any const & arg)
-      : callee(callee), args(args), arg(arg) {}
+    CallByTag(Callee * callee, T const * const * args, unsigned arity, boost::any const & arg)
+      : callee(callee), args(args), arity(arity), arg(arg) {}
 
 
     typedef typename Callee::result_type result_type;
 
     template <typename TagT>
     result_type operator() (TagT tag) const {
-      switch(args.size()) {
+      switch(arity) {
         case 0:
           //printf("call op0\n");
           return (*callee)( tag, arg );
         case 1:
           //printf("call op1\n");
-          return (*callee)( tag, args[0] );
+          return (*callee)( tag, *args[0] );
         case 2:
           //printf("call op2\n");
-          return (*callee)( tag, args[0], args[1] );
+          return (*callee)( tag, *args[0], *args[1] );
         case 3:
           //printf("call op3\n");
-          return (*callee)( tag, args[0], args[1], args[2] );
+          return (*callee)( tag, *args[0], *args[1], *args[2] );
         default:
           assert( false && "unexpeced case" );
       }
@@ -48,123 +57,202 @@ namespace metaSMT {
     }
 
     result_type operator() (metaSMT::logic::QF_BV::tag::extract_tag tag) const {
-      assert(args.size() > 0);
-      assert(args.size() == 1);
+      assert(arity == 1);
       unsigned long upper, lower;
       boost::tie(upper, lower) 
         = boost::any_cast<boost::tuple<unsigned long, unsigned long> >(arg);
-      return (*callee)( tag, upper, lower, args.front() );
+      return (*callee)( tag, upper, lower, *args[0] );
     }
 
     result_type operator() (metaSMT::logic::QF_BV::tag::zero_extend_tag tag) const {
-      assert(args.size() > 0);
-      assert(args.size() == 1);
+      assert(arity == 1);
       unsigned long width
         = boost::any_cast< unsigned long >(arg);
-      return (*callee)( tag, width, args.front() );
+      return (*callee)( tag, width, *args[0] );
     }
 
     result_type operator() (metaSMT::logic::QF_BV::tag::sign_extend_tag tag) const {
-      assert(args.size() > 0);
-      assert(args.size() == 1);
+      assert(arity == 1);
       unsigned long width
         = boost::any_cast< unsigned long >(arg);
-      return (*callee)( tag, width, args.front() );
+      return (*callee)( tag, width, *args[0] );
     }
     
     mutable Callee       * callee;
-    std::vector<T> const & args;
+    T const * const      * args;
+    unsigned               arity;
     boost::any     const & arg;
   };
 
   template <typename Callee, typename T>
-  CallByTag<Callee, T> make_callByTag(Callee * callee, std::vector<T> const & args, boost::any const & arg) {
-    return CallByTag<Callee, T>(callee, args, arg);
+  CallByTag<Callee, T> make_callByTag(Callee * callee, T const * const * args, unsigned arity, boost::any const & arg) {
+    return CallByTag<Callee, T>(callee, args, arity, arg);
   }
 
 
+  /**
+   * the solver of a GraphSolver_Context. Copies copy the solver if its
+   * results stay valid in the copy (features::copyable_results),
+   * otherwise they start with a new solver.
+   **/
+  template <typename SolverContext
+    , typename Copyable = typename features::copyable_results<SolverContext>::type >
+  struct SolverCopy : SolverContext {
+    SolverCopy() {}
+    SolverCopy( SolverCopy const & ) : SolverContext() {}
+  };
+
+  template <typename SolverContext>
+  struct SolverCopy<SolverContext, boost::mpl::true_> : SolverContext {};
+
+  typedef boost::function0<bool> ComponentTask;
+
+  /**
+   * runs the tasks one after another and returns whether all of them
+   * returned true, the tasks after the first false one are skipped
+   **/
+  inline bool run_sequentially( std::vector<ComponentTask> const & tasks ) {
+    for ( unsigned i = 0; i < tasks.size(); ++i ) {
+      if ( !tasks[i]() ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   /**
    *  GraphSolver_Context takes a SolverType. All constraints are first
    *  forwarded to a Graph_Context, for deduplication and later handed to
    *  solver.
+   *
+   *  With the option graph_components=1 solve splits the assertions and
+   *  assumptions into groups that share no variables and solves each
+   *  group with its own solver instance. The groups stay across solves:
+   *  new assertions and assumptions go to the group of their variables,
+   *  groups are merged when a new one joins them and only groups with
+   *  new constraints are solved again. The first group uses the solver
+   *  of the context. The scheduler (see set_scheduler) decides how the
+   *  groups are run, e.g. in parallel with concurrent::ParallelScheduler.
+   *  The first unsatisfiable group ends the search. This is only done as
+   *  long as no other commands were sent to the solver, and not for
+   *  solvers that support only a single instance
+   *  (features::single_instance).
    **/
   template<typename SolverContext>
   struct GraphSolver_Context {
 
     GraphSolver_Context ( ) 
-      : _gtx( new Graph_Context() ) {
-      typedef typename boost::mpl::if_<
-        /* if   = */ typename features::supports< SolverContext, setup_option_map_cmd >::type
-      , /* then = */ option::SetupOptionMapCommand
-      , /* else = */ option::NOPCommand
-      >::type Command;
-      Command::template action( _solver, _opt );
+      : _gtx( new Graph_Context() )
+      , _assertions( new SMT_ExprContainer() )
+      , _asserted( 0 )
+      , _plain( true )
+      , _scheduler( &run_sequentially ) {
+      setup_options( _solver );
     }
 
+    /**
+     * The copy shares the graph and the assertions with ctx until one
+     * of them adds new assertions, so copying does not translate
+     * anything. If the solver allows it (features::copyable_results)
+     * the copy continues from a copy of the solver of ctx and its
+     * translations. Otherwise it gets a new solver, set up with the
+     * options of ctx, that receives the assertions of ctx the next time
+     * it is used.
+     **/
     explicit GraphSolver_Context ( const GraphSolver_Context & ctx )
       : _opt( ctx._opt )
       , _gtx( ctx._gtx ) // share graph
-      , _solver() // create new solver
-      , _lookup() // create new lookup table
-      , _assertions( ctx._assertions )   // copy assertions
+      , _solver( ctx._solver ) // copy or create new solver
+      , _lookup( copyable::value ? ctx._lookup : LookupT() )
+      , _assertions( ctx._assertions )   // share assertions
+      , _asserted( copyable::value ? ctx._asserted : 0 )
       , _assumptions( ctx._assumptions ) // copy assumptions
+      , _cmd_queue( ctx._cmd_queue )     // copy pending commands
+      , _plain( ctx._plain )
+      , _scheduler( ctx._scheduler )
+      , _cone( copyable::value ? ctx._cone : std::vector<SMT_Expression>() )
+      , _seen( copyable::value ? ctx._seen : std::vector<bool>() )
+      , _owner( copyable::value ? ctx._owner : OwnerT() )
     {
-      BOOST_FOREACH(SMT_Expression e, _assertions) {
-        _solver.assertion ( _eval(e) );
-      }
-      BOOST_FOREACH(SMT_Expression e, _assumptions) {
-        _solver.assumption ( _eval(e) );
+      if ( copyable::value ) {
+        BOOST_FOREACH( boost::shared_ptr<Component> const & c, ctx._components ) {
+          boost::shared_ptr<Component> copy( new Component(*c) );
+          if ( c->solver ) {
+            copy->solver.reset( new SolverCopy<SolverContext>(*c->solver) );
+          }
+          _components.push_back( copy );
+        }
+      } else {
+        setup_options( _solver );
+        if ( ctx._asserted > 0 ) {
+          _cmd_queue.push_front( Assert_Next(ctx._asserted) );
+        }
       }
     }
 
     typedef SolverContext solver_type;
     typedef SMT_Expression result_type;
     typedef typename SolverContext::result_type solver_result;
+    typedef boost::function< bool ( std::vector<ComponentTask> const & ) > Scheduler;
 
     void assertion ( SMT_Expression e ) {
-      namespace ph=boost::phoenix;
-      _assertions.push_back(e);
-
-      Cmd f = 
-        ph::bind( &SolverContext::assertion, ph::ref(_solver),
-          ph::bind(&GraphSolver_Context<SolverContext>::_eval, ph::ref(*this), e )
-        );
-      _cmd_queue.push_back(f);
+      if ( !_assertions.unique() ) {
+        _assertions.reset( new SMT_ExprContainer(*_assertions) );
+      }
+      _assertions->push_back(e);
+      _cmd_queue.push_back( Assert_Next() );
     }
 
     void assumption( SMT_Expression e ) {
       _assumptions.push_back(e);
     }
 
-    template< typename Context, typename CMD, typename Arg1 >
+    // the queued commands get the context to work on, so copies of
+    // the context can copy the queue
+    template< typename CMD, typename Arg1 >
     struct Cmd_Caller1 {
-      Cmd_Caller1( Context & ctx, CMD c, Arg1 a1)
-      : ctx(ctx), cmd(c), arg1(a1) { }
+      Cmd_Caller1( CMD c, Arg1 a1)
+      : cmd(c), arg1(a1) { }
 
-      void operator() (){ ctx.command(cmd, arg1); }
+      void operator() ( GraphSolver_Context & ctx ){ ctx._solver.command(cmd, arg1); }
 
-      Context & ctx;
       CMD cmd;
       Arg1 arg1;
     };
 
-    template< typename Context, typename CMD >
+    template< typename CMD >
     struct Cmd_Caller0 {
-      Cmd_Caller0( Context & ctx, CMD c)
-      : ctx(ctx), cmd(c) { }
+      Cmd_Caller0( CMD c)
+      : cmd(c) { }
 
-      void operator() (){ ctx.command(cmd); }
+      void operator() ( GraphSolver_Context & ctx ){ ctx._solver.command(cmd); }
 
-      Context & ctx;
       CMD cmd;
     };
 
+    // hands the next count assertions to the solver
+    struct Assert_Next {
+      explicit Assert_Next( unsigned count = 1 )
+      : count(count) { }
+
+      void operator() ( GraphSolver_Context & ctx ) {
+        for ( unsigned i = 0; i < count; ++i ) {
+          SMT_Expression e = (*ctx._assertions)[ ctx._asserted++ ];
+          ctx._solver.assertion( ctx._eval(e) );
+        }
+      }
+
+      unsigned count;
+    };
+
     template <typename CMD, typename Arg>
     typename boost::enable_if< boost::is_same< typename CMD::result_type, void> >::type
     command (CMD const & cmd, Arg arg) 
     {
+      _plain = false;
+      join_components();
       Cmd f = 
-        Cmd_Caller1<SolverContext, CMD, Arg>(_solver, cmd, arg);
+        Cmd_Caller1<CMD, Arg>(cmd, arg);
       _cmd_queue.push_back(f);
     }
 
@@ -172,14 +260,18 @@ namespace metaSMT {
     typename boost::enable_if< boost::is_same< typename CMD::result_type, void> >::type
     command (CMD const & cmd) 
     {
+      _plain = false;
+      join_components();
       Cmd f = 
-        Cmd_Caller0<SolverContext, CMD>(_solver, cmd);
+        Cmd_Caller0<CMD>(cmd);
       _cmd_queue.push_back(f);
     }
 
     template <typename CMD>
     typename CMD::result_type command(CMD const & cmd)
     {
+      _plain = false;
+      join_components();
       sync();
       return _solver.command(cmd);
     }
@@ -192,13 +284,20 @@ namespace metaSMT {
     }
 
     void command( set_option_cmd const &tag, std::string const &key, std::string const &value ) {
+      if ( key == "graph_components" && value == "1"
+        && features::supports< SolverContext, features::single_instance >::value ) {
+        throw std::invalid_argument("graph_components: the solver supports only a single instance");
+      }
       _opt.set(key, value);
       typedef typename boost::mpl::if_<
         /* if   = */ typename features::supports< SolverContext, set_option_cmd >::type
       , /* then = */ option::SetOptionCommand
       , /* else = */ option::NOPCommand
       >::type Command;
-      Command::template action( _solver, _opt );
+      Command::template action( _solver, _opt, key, value );
+      for ( unsigned i = 1; i < _components.size(); ++i ) {
+        Command::template action( *_components[i]->solver, _opt, key, value );
+      }
     }
 
     std::string command( get_option_cmd const &, std::string const &key ) {
@@ -209,14 +308,66 @@ namespace metaSMT {
       return _opt.get(key, default_value);
     }
 
+    /**
+     * removes the graph nodes that are reachable neither from roots nor
+     * from the assertions and assumptions, see Graph_Context::collect.
+     * The solver keeps its expressions, only the cached translations of
+     * removed nodes are dropped.
+     **/
+    std::size_t command( collect_garbage_cmd const &, std::vector<result_type> & roots ) {
+      if ( !_gtx.unique() ) {
+        throw std::runtime_error("collect_garbage: graph is shared with another context");
+      }
+      // with components the queue only holds assertions for the next solve
+      if ( _components.empty() ) {
+        sync();
+      }
+
+      SMT_ExprContainer & assertions = *_assertions;
+      SMT_ExprContainer live( roots );
+      live.insert( live.end(), assertions.begin(), assertions.end() );
+      live.insert( live.end(), _assumptions.begin(), _assumptions.end() );
+      std::vector<SMT_Expression> renumber;
+      std::size_t bytes = _gtx->collect( live, &renumber );
+
+      std::copy( live.begin(), live.begin() + roots.size(), roots.begin() );
+      std::copy( live.begin() + roots.size()
+               , live.begin() + roots.size() + assertions.size()
+               , assertions.begin() );
+      std::copy( live.end() - _assumptions.size(), live.end(), _assumptions.begin() );
+
+      bytes += renumber_lookup( _lookup, renumber );
+      for ( unsigned i = 0; i < _components.size(); ++i ) {
+        Component & c = *_components[i];
+        if ( i > 0 ) {
+          bytes += renumber_lookup( c.lookup, renumber );
+        }
+        BOOST_FOREACH( SMT_Expression & e, c.assertions ) {
+          e = renumber[e];
+        }
+        BOOST_FOREACH( SMT_Expression & e, c.fresh ) {
+          e = renumber[e];
+        }
+      }
+      if ( !_components.empty() ) {
+        rebuild_components();
+      }
+      return bytes;
+    }
+
     void sync() {
-      BOOST_FOREACH( Cmd const & f, _cmd_queue) {
-        f();
+      while ( !_cmd_queue.empty() ) {
+        Cmd f = _cmd_queue.front();
+        _cmd_queue.pop_front();
+        f( *this );
       }
-      _cmd_queue.clear();
     }
 
     bool solve() {
+      if ( _plain && _opt.get("graph_components", "0") == "1" ) {
+        return solve_components();
+      }
+      join_components();
       sync();
       //BOOST_FOREACH(SMT_Expression e, _assertions) {
       //  _solver.assertion ( _eval(e) );
@@ -230,7 +381,7 @@ namespace metaSMT {
 
     void write_smt(std::ostream &os) {
       SMT_ExprContainer v;
-      std::copy(_assertions.begin(), _assertions.end(),
+      std::copy(_assertions->begin(), _assertions->end(),
                 std::back_inserter(v));
       std::copy(_assumptions.begin(), _assumptions.end(),
                 std::back_inserter(v));
@@ -246,7 +397,7 @@ namespace metaSMT {
     {
       template<typename T>
       result_type operator() (T) const {
-        return result_wrapper(&boost::logic::indeterminate);
+        return result_wrapper(boost::logic::tribool(boost::logic::indeterminate));
       }
       
       result_type operator() (logic::QF_BV::tag::var_tag const & var) const {
@@ -258,13 +409,17 @@ namespace metaSMT {
 
     result_wrapper read_value(SMT_Expression var)
     { 
-      typename LookupT::const_iterator ite
-        = _lookup.find(var);
-      if ( ite != _lookup.end() ) {
-        return _solver.read_value( _eval( var ) ); 
+      for ( unsigned i = 1; i < _components.size(); ++i ) {
+        Component & c = *_components[i];
+        if ( var < c.lookup.size() && c.lookup[var] ) {
+          return c.solver->read_value( *c.lookup[var] );
+        }
+      }
+      if ( var < _lookup.size() && _lookup[var] ) {
+        return _solver.read_value( *_lookup[var] );
       } else {
-        return boost::apply_visitor(create_x_result()
-            , boost::get(boost::vertex_tag, _gtx->graph(), var));
+        Tag tag = _gtx->graph().tag(var);
+        return boost::apply_visitor(create_x_result(), tag);
       }
     }
 
@@ -273,40 +428,438 @@ namespace metaSMT {
 
     SMT_Expression evaluate ( result_type r ) { return r; }
 
+    /**
+     * the scheduler of the components of graph_components, it gets one
+     * task per component and returns whether all of them are
+     * satisfiable. The default is run_sequentially.
+     **/
+    void set_scheduler( Scheduler const & scheduler ) {
+      _scheduler = scheduler;
+    }
+
     private:
-      solver_result  _eval( SMT_Expression e) {
-        typename LookupT::const_iterator ite = _lookup.find(e);
-        if ( ite != _lookup.end() ) {
-          return ite->second;
+      // hands the options to a new solver
+      void setup_options( SolverCopy<SolverContext> & solver ) {
+        typedef typename boost::mpl::if_<
+          /* if   = */ typename features::supports< SolverContext, setup_option_map_cmd >::type
+        , /* then = */ option::SetupOptionMapCommand
+        , /* else = */ option::NOPCommand
+        >::type Command;
+        Command::template action( solver, _opt );
+      }
+
+      solver_result _eval( SMT_Expression e ) {
+        return translate( _solver, _lookup, _pending, _gtx->graph(), e );
+      }
+
+      // the solver result of each node that was translated already
+      typedef typename std::vector< boost::optional<solver_result> > LookupT;
+      typedef std::vector<SMT_Expression> SMT_ExprContainer;
+
+      /**
+       * translates e and the nodes of its cone that are not in lookup
+       * yet, in post order with an explicit stack (pending)
+       **/
+      template <typename Solver>
+      static solver_result translate( Solver & solver, LookupT & lookup
+        , std::vector<SMT_Expression> & pending, SMT_Graph const & g, SMT_Expression e )
+      {
+        if ( lookup.size() < g.size() ) {
+          lookup.resize( g.size() );
+        }
+        if ( lookup[e] ) {
+          return *lookup[e];
         }
 
-        SMT_Graph const & g = _gtx->graph();
+        pending.push_back( e );
+        while ( !pending.empty() ) {
+          const SMT_Expression n = pending.back();
+          if ( lookup[n] ) {
+            pending.pop_back();
+            continue;
+          }
+
+          const unsigned arity = g.arity(n);
+          bool ready = true;
+          for ( unsigned i = 0; i < arity; ++i ) {
+            if ( !lookup[ g.child(n, i) ] ) {
+              pending.push_back( g.child(n, i) );
+              ready = false;
+            }
+          }
+          if ( !ready ) {
+            continue;
+          }
+          pending.pop_back();
+
+          solver_result const * args[SMT_Graph::MAX_ARITY];
+          for ( unsigned i = 0; i < arity; ++i ) {
+            args[i] = lookup[ g.child(n, i) ].get_ptr();
+          }
+          boost::any arg = g.arg(n);
+          Tag tag        = g.tag(n);
+          lookup[n] = boost::apply_visitor( make_callByTag(&solver, args, arity, arg), tag );
+        }
+        return *lookup[e];
+      }
+
+      // moves the entries of lookup to their new nodes, returns the bytes freed
+      std::size_t renumber_lookup( LookupT & lookup, std::vector<SMT_Expression> const & renumber ) {
+        LookupT renumbered( _gtx->graph().size() );
+        for ( SMT_Expression e = 0; e < lookup.size(); ++e ) {
+          if ( lookup[e] && renumber[e] != SMT_Graph::none() ) {
+            renumbered[ renumber[e] ] = lookup[e];
+          }
+        }
+        std::size_t bytes = 0;
+        if ( lookup.capacity() > renumbered.capacity() ) {
+          bytes = ( lookup.capacity() - renumbered.capacity() ) * sizeof(typename LookupT::value_type);
+        }
+        lookup.swap( renumbered );
+        return bytes;
+      }
+
+      /**
+       * assertions and assumptions that share no variables with the
+       * other components. The first component is solved by _solver with
+       * _lookup and _pending, the others by a solver of their own.
+       **/
+      struct Component {
+        Component() : bound(false), sat(false) { }
+
+        boost::shared_ptr< SolverCopy<SolverContext> > solver;
+        LookupT lookup;
+        std::vector<SMT_Expression> pending;
+        SMT_ExprContainer assertions;
+        // the assertions not handed to the solver yet
+        SMT_ExprContainer fresh;
+        SMT_ExprContainer assumptions;
+        // the component has variables
+        bool bound;
+        // the result of the last solve of the component
+        bool sat;
+      };
 
-        std::vector<solver_result> args;
-        // ... fill args
-        BOOST_FOREACH(SMT_Edge k, out_edges(e,g)) {
-          args.push_back( _eval(target(k,g)) );
+      struct Solve_Component {
+        Solve_Component( SolverCopy<SolverContext> & solver, LookupT & lookup
+          , std::vector<SMT_Expression> & pending, Component & c, SMT_Graph const & g )
+        : solver(solver), lookup(lookup), pending(pending), c(c), g(g) { }
+
+        bool operator() () const {
+          BOOST_FOREACH( SMT_Expression e, c.fresh ) {
+            solver.assertion( translate(solver, lookup, pending, g, e) );
+          }
+          c.fresh.clear();
+          BOOST_FOREACH( SMT_Expression e, c.assumptions ) {
+            solver.assumption( translate(solver, lookup, pending, g, e) );
+          }
+          c.sat = solver.solve();
+          return c.sat;
         }
-        
-        boost::any arg = boost::get(boost::vertex_arg, g, e);
-        Tag tag        = boost::get(boost::vertex_tag, g, e);
 
-        solver_result ret = boost::apply_visitor( make_callByTag(&_solver, args, arg), tag); 
-        _lookup.insert( std::make_pair(e, ret) );
-        return ret;
+        SolverCopy<SolverContext> & solver;
+        LookupT & lookup;
+        std::vector<SMT_Expression> & pending;
+        Component & c;
+        SMT_Graph const & g;
       };
 
+      static SMT_Expression find( std::vector<SMT_Expression> & parent, SMT_Expression v ) {
+        while ( parent[v] != v ) {
+          parent[v] = parent[ parent[v] ];
+          v = parent[v];
+        }
+        return v;
+      }
+
+      // some variable in the cone of a node that was placed already
+      SMT_Expression variable_of( SMT_Expression n ) const {
+        return _gtx->graph().variable(n) ? n : _cone[n];
+      }
+
+      // moves the component of the representative rep (if any) to owners
+      void take_owner( SMT_Expression rep, std::vector<unsigned> & owners ) {
+        OwnerT::iterator ite = _owner.find( rep );
+        if ( ite == _owner.end() ) {
+          return;
+        }
+        if ( std::find( owners.begin(), owners.end(), ite->second ) == owners.end() ) {
+          owners.push_back( ite->second );
+        }
+        _owner.erase( ite );
+      }
+
+      void unite( SMT_Expression a, SMT_Expression b, std::vector<unsigned> & owners ) {
+        a = find( _cone, a );
+        b = find( _cone, b );
+        if ( a == b ) {
+          return;
+        }
+        take_owner( a, owners );
+        take_owner( b, owners );
+        _cone[ std::max(a, b) ] = std::min(a, b);
+      }
+
+      /**
+       * adds the nodes in the cone of e that were not placed yet to the
+       * union-find and returns the representative variable of e (none if
+       * the cone has no variables). The components of the representatives
+       * that e joins are taken from _owner and returned in owners.
+       **/
+      SMT_Expression place( SMT_Expression e, std::vector<unsigned> & owners ) {
+        SMT_Graph const & g = _gtx->graph();
+        if ( _cone.size() < g.size() ) {
+          _cone.resize( g.size(), SMT_Graph::none() );
+          _seen.resize( g.size() );
+        }
+
+        std::vector<SMT_Expression> added;
+        std::vector<SMT_Expression> stack;
+        if ( !_seen[e] ) {
+          _seen[e] = true;
+          stack.push_back( e );
+        }
+        while ( !stack.empty() ) {
+          const SMT_Expression n = stack.back();
+          stack.pop_back();
+          added.push_back( n );
+          for ( unsigned i = 0; i < g.arity(n); ++i ) {
+            const SMT_Expression c = g.child(n, i);
+            if ( !_seen[c] ) {
+              _seen[c] = true;
+              stack.push_back( c );
+            }
+          }
+        }
+
+        // children have smaller indices than their parents
+        std::sort( added.begin(), added.end() );
+        BOOST_FOREACH( SMT_Expression n, added ) {
+          if ( g.variable(n) ) {
+            _cone[n] = n;
+            continue;
+          }
+          for ( unsigned i = 0; i < g.arity(n); ++i ) {
+            const SMT_Expression v = variable_of( g.child(n, i) );
+            if ( v == SMT_Graph::none() ) continue;
+            if ( _cone[n] == SMT_Graph::none() ) {
+              _cone[n] = v;
+            } else {
+              unite( _cone[n], v, owners );
+            }
+          }
+        }
+
+        const SMT_Expression v = variable_of( e );
+        if ( v == SMT_Graph::none() ) {
+          return v;
+        }
+        const SMT_Expression rep = find( _cone, v );
+        take_owner( rep, owners );
+        return rep;
+      }
+
+      unsigned new_component() {
+        boost::shared_ptr<Component> c( new Component() );
+        c->solver.reset( new SolverCopy<SolverContext>() );
+        setup_options( *c->solver );
+        _components.push_back( c );
+        return _components.size() - 1;
+      }
+
+      /**
+       * merges the components in owners into target, which receives
+       * their assertions as new ones. Returns the new index of target.
+       **/
+      unsigned merge( std::vector<unsigned> const & owners, unsigned target ) {
+        std::vector<bool> merged( _components.size() );
+        Component & t = *_components[target];
+        BOOST_FOREACH( unsigned i, owners ) {
+          if ( i == target ) continue;
+          Component const & c = *_components[i];
+          t.assertions.insert( t.assertions.end(), c.assertions.begin(), c.assertions.end() );
+          t.fresh.insert( t.fresh.end(), c.assertions.begin(), c.assertions.end() );
+          t.assumptions.insert( t.assumptions.end(), c.assumptions.begin(), c.assumptions.end() );
+          merged[i] = true;
+        }
+        if ( std::find( merged.begin(), merged.end(), true ) == merged.end() ) {
+          return target;
+        }
+
+        std::vector<unsigned> index( _components.size() );
+        unsigned n = 0;
+        for ( unsigned i = 0; i < _components.size(); ++i ) {
+          index[i] = n;
+          if ( !merged[i] ) {
+            _components[n++] = _components[i];
+          }
+        }
+        _components.resize( n );
+        for ( OwnerT::iterator ite = _owner.begin(); ite != _owner.end(); ++ite ) {
+          ite->second = index[ite->second];
+        }
+        return index[target];
+      }
+
+      /**
+       * the component of e. The components that e joins are merged into
+       * the first component if it is one of them (or to_first holds),
+       * otherwise into the one with the most assertions. Cones without
+       * variables belong to the first component, as do the first
+       * variables.
+       **/
+      unsigned route( SMT_Expression e, bool to_first ) {
+        std::vector<unsigned> owners;
+        const SMT_Expression rep = place( e, owners );
+
+        unsigned target = 0;
+        if ( to_first || rep == SMT_Graph::none()
+          || std::find( owners.begin(), owners.end(), 0u ) != owners.end() ) {
+          target = 0;
+        } else if ( owners.empty() ) {
+          target = _components[0]->bound ? new_component() : 0;
+        } else {
+          target = owners[0];
+          BOOST_FOREACH( unsigned i, owners ) {
+            if ( _components[i]->assertions.size() > _components[target]->assertions.size() ) {
+              target = i;
+            }
+          }
+        }
+        target = merge( owners, target );
+
+        if ( rep != SMT_Graph::none() ) {
+          _owner[rep] = target;
+          _components[target]->bound = true;
+        }
+        return target;
+      }
+
+      /**
+       * routes the new assertions and the assumptions to their components
+       * and solves the components that got new ones or were not
+       * satisfiable the last time
+       **/
+      bool solve_components() {
+        if ( _components.empty() ) {
+          // the first component continues with the assertions of _solver
+          _components.push_back( boost::shared_ptr<Component>( new Component() ) );
+          for ( unsigned i = 0; i < _asserted; ++i ) {
+            const SMT_Expression e = (*_assertions)[i];
+            _components[ route(e, true) ]->assertions.push_back( e );
+          }
+        }
+        // while plain, the queue only hands out the assertions routed here
+        _cmd_queue.clear();
+        for ( ; _asserted < _assertions->size(); ++_asserted ) {
+          const SMT_Expression e = (*_assertions)[_asserted];
+          Component & c = *_components[ route(e, false) ];
+          c.assertions.push_back( e );
+          c.fresh.push_back( e );
+        }
+        BOOST_FOREACH( SMT_Expression e, _assumptions ) {
+          _components[ route(e, false) ]->assumptions.push_back( e );
+        }
+        _assumptions.clear();
+
+        SMT_Graph const & g = _gtx->graph();
+        std::vector<ComponentTask> tasks;
+        for ( unsigned i = 0; i < _components.size(); ++i ) {
+          Component & c = *_components[i];
+          if ( c.sat && c.fresh.empty() && c.assumptions.empty() ) {
+            continue;
+          }
+          if ( i == 0 ) {
+            tasks.push_back( Solve_Component( _solver, _lookup, _pending, c, g ) );
+          } else {
+            tasks.push_back( Solve_Component( *c.solver, c.lookup, c.pending, c, g ) );
+          }
+        }
+        const bool sat = _scheduler( tasks );
+        for ( unsigned i = 0; i < _components.size(); ++i ) {
+          _components[i]->assumptions.clear();
+        }
+        return sat;
+      }
+
+      /**
+       * hands the assertions of all components to _solver, which solves
+       * alone afterwards
+       **/
+      void join_components() {
+        if ( _components.empty() ) {
+          return;
+        }
+        BOOST_FOREACH( SMT_Expression e, _components[0]->fresh ) {
+          _solver.assertion( _eval(e) );
+        }
+        for ( unsigned i = 1; i < _components.size(); ++i ) {
+          BOOST_FOREACH( SMT_Expression e, _components[i]->assertions ) {
+            _solver.assertion( _eval(e) );
+          }
+        }
+        _components.clear();
+        _cone.clear();
+        _seen.clear();
+        _owner.clear();
+      }
+
+      /**
+       * builds the union-find again from the assertions of the components
+       * (after collect_garbage), components without assertions besides
+       * the first one are dropped
+       **/
+      void rebuild_components() {
+        unsigned n = 1;
+        for ( unsigned i = 1; i < _components.size(); ++i ) {
+          if ( !_components[i]->assertions.empty() ) {
+            _components[n++] = _components[i];
+          }
+        }
+        _components.resize( n );
+
+        _cone.clear();
+        _seen.clear();
+        _owner.clear();
+        for ( unsigned i = 0; i < _components.size(); ++i ) {
+          BOOST_FOREACH( SMT_Expression e, _components[i]->assertions ) {
+            std::vector<unsigned> owners;
+            const SMT_Expression rep = place( e, owners );
+            if ( rep != SMT_Graph::none() ) {
+              _owner[rep] = i;
+            }
+          }
+        }
+      }
+
+      typedef typename features::copyable_results<SolverContext>::type copyable;
+
       Options _opt;
       boost::shared_ptr<Graph_Context> _gtx;
-      solver_type _solver;
-      typedef typename std::map<SMT_Expression, solver_result> LookupT;
-      typedef boost::function0<void> Cmd;
+      SolverCopy<SolverContext> _solver;
+      typedef boost::function1<void, GraphSolver_Context &> Cmd;
       typedef std::list< Cmd > Cmd_Queue;
-      typedef std::vector<SMT_Expression> SMT_ExprContainer;
       LookupT _lookup;
-      SMT_ExprContainer _assertions;
+      // shared with copies until one of them adds an assertion
+      boost::shared_ptr<SMT_ExprContainer> _assertions;
+      // the number of assertions handed to _solver
+      unsigned _asserted;
       SMT_ExprContainer _assumptions;
+      // nodes waiting for their inputs in _eval
+      std::vector<SMT_Expression> _pending;
       Cmd_Queue _cmd_queue;
+      // no commands besides assertions were sent to the solver
+      bool _plain;
+      Scheduler _scheduler;
+      // the components of graph_components, the first one uses _solver
+      std::vector< boost::shared_ptr<Component> > _components;
+      // the union-find of the variables in the components: the parent of
+      // each variable node and some variable (or none) of the other nodes
+      std::vector<SMT_Expression> _cone;
+      std::vector<bool> _seen;
+      // the component of each representative variable
+      typedef std::map<SMT_Expression, unsigned> OwnerT;
+      OwnerT _owner;
   };
 
   namespace features {
@@ -329,6 +882,10 @@ namespace metaSMT {
     template<typename Context>
     struct supports< GraphSolver_Context<Context>, get_option_cmd>
     : boost::mpl::true_ {};
+
+    template<typename Context>
+    struct supports< GraphSolver_Context<Context>, collect_garbage_cmd>
+    : boost::mpl::true_ {};
   }
 
   template < typename SolverType >
@@ -4,24 +4,74 @@
 #include "support/SMT_Graph.hpp"
 #include "support/dot_SMT_Graph.hpp"
 #include "support/SMT_File_Writer.hpp"
+#include "support/UniqueTable.hpp"
 #include "API/BoolEvaluator.hpp"
+#include "API/CollectGarbage.hpp"
 
 #include <boost/proto/core.hpp>
 #include <boost/proto/context.hpp>
 #include <boost/proto/proto.hpp>
 #include <boost/proto/make_expr.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/mpl/bool.hpp>
 #include <boost/tr1/unordered_map.hpp>
 #include <boost/tuple/tuple_comparison.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <map>
 #include <exception>
+#include <vector>
 
 namespace proto = boost::proto;
 
 namespace metaSMT {
+
+  /**
+   * operators whose operands the Graph_Context may swap
+   **/
+  template <typename TAG>
+  struct is_commutative_tag : boost::mpl::false_ {};
+
+  /**
+   * associative and idempotent operators, the Graph_Context flattens
+   * their chains
+   **/
+  template <typename TAG>
+  struct is_flattened_tag : boost::mpl::false_ {};
+
+#define metaSMT_COMMUTATIVE( TAG ) \
+  template <> struct is_commutative_tag< TAG > : boost::mpl::true_ {};
+#define metaSMT_FLATTENED( TAG ) \
+  template <> struct is_flattened_tag< TAG > : boost::mpl::true_ {};
+
+  metaSMT_COMMUTATIVE( logic::tag::equal_tag )
+  metaSMT_COMMUTATIVE( logic::tag::nequal_tag )
+  metaSMT_COMMUTATIVE( logic::tag::and_tag )
+  metaSMT_COMMUTATIVE( logic::tag::nand_tag )
+  metaSMT_COMMUTATIVE( logic::tag::or_tag )
+  metaSMT_COMMUTATIVE( logic::tag::nor_tag )
+  metaSMT_COMMUTATIVE( logic::tag::xor_tag )
+  metaSMT_COMMUTATIVE( logic::tag::xnor_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvand_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvnand_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvor_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvnor_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvxor_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvxnor_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvcomp_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvadd_tag )
+  metaSMT_COMMUTATIVE( logic::QF_BV::tag::bvmul_tag )
+
+  metaSMT_FLATTENED( logic::tag::and_tag )
+  metaSMT_FLATTENED( logic::tag::or_tag )
+  metaSMT_FLATTENED( logic::QF_BV::tag::bvand_tag )
+  metaSMT_FLATTENED( logic::QF_BV::tag::bvor_tag )
+
+#undef metaSMT_COMMUTATIVE
+#undef metaSMT_FLATTENED
  
   /**
    * \ingroup Backend
@@ -33,6 +83,16 @@ namespace metaSMT {
    * a node in the internal graph.
    * 
    * The internal graph is an SMT_Graph and can be access with graph()
+   *
+   * Equal expressions are evaluated to the same node. Nodes are hash
+   * consed in a UniqueTable on their signature (tag, inputs and
+   * parameters); the operands of commutative operators are sorted, and
+   * chains of and/or are flattened into a canonical chain over their
+   * sorted, unique operands.
+   *
+   * Nodes are never removed implicitly. collect() (or the
+   * collect_garbage command) removes the nodes that are unreachable
+   * from a set of roots and renumbers the remaining ones.
    */
   struct Graph_Context 
     : proto::callable_context< Graph_Context, proto::null_context >
@@ -56,8 +116,7 @@ namespace metaSMT {
       if ( ite!= _variables.end() ) {
         return ite->second;
       } else {
-        SMT_Expression ret = boost::add_vertex(_g);
-        boost::put(boost::vertex_tag, _g, ret, tag);
+        SMT_Expression ret = _g.add(tag);
         _variables.insert( std::make_pair(tag.id, ret) );
         return ret;
       }
@@ -73,8 +132,7 @@ namespace metaSMT {
       if ( ite!= _variables.end() ) {
         return ite->second;
       } else {
-        SMT_Expression ret = boost::add_vertex(_g);
-        boost::put(boost::vertex_tag, _g, ret, tag);
+        SMT_Expression ret = _g.add(tag);
         _variables.insert( std::make_pair(tag.id, ret) );
         return ret;
       }
@@ -86,17 +144,10 @@ namespace metaSMT {
         , Lower lower
         , Expr arg
     ) {
-      result_type node = proto::eval(arg, *this);
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::put(boost::vertex_arg, _g, ret,
-        boost::tuple<unsigned long, unsigned long>(
-          proto::value(upper), proto::value(lower)) 
-      );
-      SMT_Edge e; bool b;
-      boost::tie(e, b) = boost::add_edge(ret, node, _g);
-      put(boost::edge_input, _g, e, 1);
-      return ret;
+      Node key( tag, 1, proto::eval(arg, *this) );
+      key.params[0] = proto::value(upper);
+      key.params[1] = proto::value(lower);
+      return node( key );
     }
 
     template<typename Width, typename Expr >
@@ -104,16 +155,9 @@ namespace metaSMT {
         , Width width
         , Expr arg
     ) {
-      result_type node = proto::eval(arg, *this);
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::put(boost::vertex_arg, _g, ret,
-          proto::value(width)
-      );
-      SMT_Edge e; bool b;
-      boost::tie(e, b) = boost::add_edge(ret, node, _g);
-      put(boost::edge_input, _g, e, 1);
-      return ret;
+      Node key( tag, 1, proto::eval(arg, *this) );
+      key.params[0] = proto::value(width);
+      return node( key );
     }
 
     template<typename Width, typename Expr >
@@ -121,16 +165,9 @@ namespace metaSMT {
         , Width width
         , Expr arg
     ) {
-      result_type node = proto::eval(arg, *this);
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::put(boost::vertex_arg, _g, ret,
-          proto::value(width)
-      );
-      SMT_Edge e; bool b;
-      boost::tie(e, b) = boost::add_edge(ret, node, _g);
-      put(boost::edge_input, _g, e, 1);
-      return ret;
+      Node key( tag, 1, proto::eval(arg, *this) );
+      key.params[0] = proto::value(width);
+      return node( key );
     }
 
     template < typename TagT >
@@ -143,66 +180,27 @@ namespace metaSMT {
     typename boost::disable_if< Evaluator<TagT>, result_type >::type
     operator() ( proto::tag::terminal const &, TagT const &tag )
     {
-      Tag t1 (tag);
-      Op0LookupT::const_iterator ite = _op0Lookup.find( t1 );
-      if( ite != _op0Lookup.end() ) {
-        return ite->second;
-      }
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      _op0Lookup.insert( std::make_pair( t1, ret) );
-      return ret;
+      return node( Node(tag, 0) );
     }
 
     template<typename TAG, typename Expr1, typename Expr2>
     result_type operator() (TAG tag, Expr1 e1, Expr2 e2)
     {
-      Tag t1 (tag);
       result_type arg1 = proto::eval(e1, *this);
       result_type arg2 = proto::eval(e2, *this);
-      Op2LookupT::const_iterator ite =
-        _op2Lookup.find( boost::make_tuple(t1, arg1, arg2) );
-      if( ite != _op2Lookup.end() ) {
-        return ite->second;
+      if ( is_flattened_tag<TAG>::value ) {
+        return flatten( tag, arg1, arg2 );
       }
-      result_type ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::add_edge(ret, arg1, _g);
-      SMT_Edge e; bool b;
-      boost::tie(e, b) = boost::add_edge(ret, arg2, _g);
-      put(boost::edge_input, _g, e, 1);
-      _op2Lookup.insert( std::make_pair( 
-        boost::make_tuple( t1, arg1, arg2 ),
-        ret
-      ));
-      return ret;
+      return binary( tag, is_commutative_tag<TAG>::value, arg1, arg2 );
     }
 
     template<typename TAG, typename Expr1, typename Expr2, typename Expr3>
     result_type operator() (TAG tag, Expr1 e1, Expr2 e2, Expr3 e3)
     {
-      Tag t1 (tag);
       result_type arg1 = proto::eval(e1, *this);
       result_type arg2 = proto::eval(e2, *this);
       result_type arg3 = proto::eval(e3, *this);
-      Op3LookupT::const_iterator ite =
-        _op3Lookup.find( boost::make_tuple(t1, arg1, arg2, arg3) );
-      if( ite != _op3Lookup.end() ) {
-        return ite->second;
-      }
-      result_type ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::add_edge(ret, arg1, _g);
-      SMT_Edge e; bool b;
-      boost::tie(e, b) = boost::add_edge(ret, arg2, _g);
-      put(boost::edge_input, _g, e, 1);
-      boost::tie(e, b) = boost::add_edge(ret, arg3, _g);
-      put(boost::edge_input, _g, e, 2);
-      _op3Lookup.insert( std::make_pair( 
-        boost::make_tuple( t1, arg1, arg2, arg3),
-        ret
-      ));
-      return ret;
+      return node( Node(tag, 3, arg1, arg2, arg3) );
     }
 
 
@@ -223,15 +221,13 @@ namespace metaSMT {
         }
       }
   
-      ConstantLookupT::const_iterator ite
-        = _constants.find( boost::make_tuple(tag, val, width) );
-      if ( ite != _constants.end()) {
-        return ite->second;
+      ConstantOpT key = boost::make_tuple(tag, val, width);
+      if ( result_type const * r = _constants.find( key ) ) {
+        return *r;
       }
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::put(boost::vertex_arg, _g, ret, boost::make_tuple( val, width) );
-      _constants.insert( std::make_pair( boost::make_tuple(tag, val, width), ret) );
+      SMT_Expression ret = _g.add(tag, 0, SMT_Graph::none(), SMT_Graph::none()
+        , SMT_Graph::none(), val, width);
+      _constants.insert( key, ret );
       return ret;
     }
 
@@ -252,15 +248,13 @@ namespace metaSMT {
         }
       }
   
-      ConstantLookupT::const_iterator ite
-        = _constants.find( boost::make_tuple(tag, val, width) );
-      if ( ite != _constants.end()) {
-        return ite->second;
+      ConstantOpT key = boost::make_tuple(tag, val, width);
+      if ( result_type const * r = _constants.find( key ) ) {
+        return *r;
       }
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::put(boost::vertex_arg, _g, ret, boost::make_tuple( val, width) );
-      _constants.insert( std::make_pair( boost::make_tuple(tag, val, width), ret) );
+      SMT_Expression ret = _g.add(tag, 0, SMT_Graph::none(), SMT_Graph::none()
+        , SMT_Graph::none(), val, width);
+      _constants.insert( key, ret );
       return ret;
     }
 
@@ -279,15 +273,12 @@ namespace metaSMT {
         }
       }
   
-      ConstantLookupT::const_iterator ite
-        = _constants.find( boost::make_tuple(tag, val) );
-      if ( ite != _constants.end()) {
-        return ite->second;
+      ConstantOpT key = boost::make_tuple(tag, val);
+      if ( result_type const * r = _constants.find( key ) ) {
+        return *r;
       }
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::put(boost::vertex_arg, _g, ret, proto::value(value));
-      _constants.insert( std::make_pair( boost::make_tuple(tag, val), ret ) );
+      SMT_Expression ret = _g.add(tag, val);
+      _constants.insert( key, ret );
       return ret;
     }
     
@@ -297,35 +288,19 @@ namespace metaSMT {
     ) {
       const std::string val = proto::value(value);
 
-      ConstantLookupT::const_iterator ite
-        = _constants.find( boost::make_tuple(tag, val) );
-      if ( ite != _constants.end()) {
-        return ite->second;
+      ConstantOpT key = boost::make_tuple(tag, val);
+      if ( result_type const * r = _constants.find( key ) ) {
+        return *r;
       }
-      SMT_Expression ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::put(boost::vertex_arg, _g, ret, proto::value(value));
-      _constants.insert( std::make_pair( boost::make_tuple(tag, val), ret ) );
+      SMT_Expression ret = _g.add(tag, val);
+      _constants.insert( key, ret );
       return ret;
     }
     
     template< typename TAG, typename Expr1>
     result_type operator() (TAG tag, Expr1 const & e1) 
     {
-      result_type arg1 = proto::eval(e1, *this);
-      Op1LookupT::const_iterator ite =
-        _op1Lookup.find( boost::make_tuple(tag, arg1) );
-      if( ite != _op1Lookup.end() ) {
-        return ite->second;
-      }
-      result_type ret = boost::add_vertex(_g);
-      boost::put(boost::vertex_tag, _g, ret, tag);
-      boost::add_edge(ret, arg1, _g);
-      _op1Lookup.insert( std::make_pair( 
-        boost::make_tuple( tag, arg1 ),
-        ret
-      ));
-      return ret;
+      return node( Node(tag, 1, proto::eval(e1, *this)) );
     }
 
     /**
@@ -343,6 +318,252 @@ namespace metaSMT {
       ::metaSMT::write_smt(out, _g, assertions);
     }
 
+    /**
+     * removes the nodes that are not reachable from roots and renumbers
+     * the others in their order, roots are updated in place. All other
+     * expressions of this context are invalid afterwards. If given,
+     * renumbering receives the new index of every old node
+     * (SMT_Graph::none() for removed nodes).
+     *
+     * \return the number of bytes reclaimed
+     */
+    std::size_t collect( std::vector<result_type> & roots
+                       , std::vector<result_type> * renumbering = 0 )
+    {
+      const std::size_t before = memory();
+
+      std::vector<bool> live( _g.size() );
+      for ( unsigned i = 0; i < roots.size(); ++i ) {
+        live[ roots[i] ] = true;
+      }
+      // children have smaller indices than their parents
+      for ( result_type n = _g.size(); n-- > 0; ) {
+        if ( !live[n] ) continue;
+        for ( unsigned i = 0; i < _g.arity(n); ++i ) {
+          live[ _g.child(n, i) ] = true;
+        }
+      }
+
+      std::vector<result_type> renumber;
+      _g.compact( live, renumber );
+
+      _nodes.retain( Renumber(renumber) );
+      _constants.retain( Renumber(renumber) );
+      for ( VariableLookupT::iterator ite = _variables.begin(); ite != _variables.end(); ) {
+        if ( renumber[ite->second] == SMT_Graph::none() ) {
+          _variables.erase( ite++ );
+        } else {
+          ite->second = renumber[ite->second];
+          ++ite;
+        }
+      }
+      // the leaves of a live chain are live, too
+      std::vector<result_type> leaves;
+      _chains.retain( RenumberChain(renumber, _leaves, leaves) );
+      _leaves.swap( leaves );
+
+      for ( unsigned i = 0; i < roots.size(); ++i ) {
+        roots[i] = renumber[ roots[i] ];
+      }
+      if ( renumbering ) {
+        renumbering->swap( renumber );
+      }
+
+      const std::size_t after = memory();
+      return before > after ? before - after : 0;
+    }
+
+    std::size_t command( collect_garbage_cmd const &, std::vector<result_type> & roots ) {
+      return collect( roots );
+    }
+
+    /**
+     * \return bytes used by the graph and the lookup tables (approx.)
+     */
+    std::size_t memory() const {
+      return _g.memory() + _nodes.memory() + _constants.memory()
+        + _variables.size() * sizeof(VariableLookupT::value_type)
+        + _chains.memory() + _leaves.capacity() * sizeof(result_type);
+    }
+
+    private:
+      /**
+       * signature of a node: tag, inputs and parameters (e.g. of extract)
+       **/
+      struct Node {
+        Node() : arity(0) {
+          args[0] = args[1] = args[2] = 0;
+          params[0] = params[1] = 0;
+        }
+
+        Node( Tag const & tag, unsigned arity
+          , result_type a = 0, result_type b = 0, result_type c = 0 )
+          : tag(tag), arity(arity)
+        {
+          args[0] = a; args[1] = b; args[2] = c;
+          params[0] = params[1] = 0;
+        }
+
+        Tag tag;
+        unsigned arity;
+        result_type args[3];
+        unsigned long params[2];
+      };
+
+      // the id of variable tags, 0 for operators
+      struct tag_id : boost::static_visitor<std::size_t> {
+        template <typename T>
+        std::size_t operator() (T const &) const { return 0; }
+        std::size_t operator() (logic::tag::var_tag const & t) const { return t.id; }
+        std::size_t operator() (logic::QF_BV::tag::var_tag const & t) const { return t.id; }
+        std::size_t operator() (logic::Array::tag::array_var_tag const & t) const { return t.id; }
+      };
+
+      struct NodeHash {
+        std::size_t operator() (Node const & n) const {
+          tag_id id;
+          std::size_t seed = n.tag.which();
+          boost::hash_combine(seed, boost::apply_visitor(id, n.tag));
+          for ( unsigned i = 0; i < n.arity; ++i ) {
+            boost::hash_combine(seed, n.args[i]);
+          }
+          boost::hash_combine(seed, n.params[0]);
+          boost::hash_combine(seed, n.params[1]);
+          return seed;
+        }
+      };
+
+      struct NodeEqual {
+        bool operator() (Node const & a, Node const & b) const {
+          if ( a.arity != b.arity || a.tag.which() != b.tag.which()
+            || a.params[0] != b.params[0] || a.params[1] != b.params[1] ) {
+            return false;
+          }
+          for ( unsigned i = 0; i < a.arity; ++i ) {
+            if ( a.args[i] != b.args[i] ) return false;
+          }
+          return !(a.tag < b.tag) && !(b.tag < a.tag);
+        }
+      };
+
+      /**
+       * the node of signature key, added to the graph if it is new
+       **/
+      result_type node( Node const & key ) {
+        if ( result_type const * r = _nodes.find( key ) ) {
+          return *r;
+        }
+        result_type ret = _g.add( key.tag, key.arity
+          , key.args[0], key.args[1], key.args[2]
+          , key.params[0], key.params[1] );
+        _nodes.insert( key, ret );
+        return ret;
+      }
+
+      result_type binary( Tag const & tag, bool commutative
+        , result_type arg1, result_type arg2 )
+      {
+        if ( commutative && arg2 < arg1 ) {
+          std::swap( arg1, arg2 );
+        }
+        return node( Node(tag, 2, arg1, arg2) );
+      }
+
+      // chains with more operands are not flattened
+      enum { MAX_FLATTENED = 16 };
+
+      /**
+       * tag(arg1, arg2) as chain over the sorted operands of arg1 and
+       * arg2, where chains of the same tag contribute their operands
+       **/
+      result_type flatten( Tag const & tag, result_type arg1, result_type arg2 ) {
+        std::vector<result_type> leaves;
+        operands( tag, arg1, leaves );
+        operands( tag, arg2, leaves );
+        std::sort( leaves.begin(), leaves.end() );
+        leaves.erase( std::unique( leaves.begin(), leaves.end() ), leaves.end() );
+        if ( leaves.size() > MAX_FLATTENED ) {
+          return binary( tag, true, arg1, arg2 );
+        }
+
+        result_type ret = leaves[0];
+        for ( unsigned i = 1; i < leaves.size(); ++i ) {
+          ret = binary( tag, true, ret, leaves[i] );
+        }
+        // only the root knows its leaves, the prefixes stay plain nodes
+        if ( leaves.size() > 1 && !_chains.find( ret ) ) {
+          Chain chain = { tag.which(), unsigned(_leaves.size()), unsigned(leaves.size()) };
+          _leaves.insert( _leaves.end(), leaves.begin(), leaves.end() );
+          _chains.insert( ret, chain );
+        }
+        return ret;
+      }
+
+      void operands( Tag const & tag, result_type e, std::vector<result_type> & leaves ) {
+        Chain const * chain = _chains.find( e );
+        if ( chain && chain->which == tag.which() ) {
+          std::vector<result_type>::const_iterator first = _leaves.begin() + chain->first;
+          leaves.insert( leaves.end(), first, first + chain->size );
+        } else {
+          leaves.push_back( e );
+        }
+      }
+
+      // the tag.which() of a flattened chain and the range of its sorted
+      // operands in _leaves
+      struct Chain {
+        int which;
+        unsigned first;
+        unsigned size;
+      };
+
+      // renumbers the entries of the lookup tables after compact
+      struct Renumber {
+        explicit Renumber( std::vector<result_type> const & renumber )
+          : renumber(renumber) {}
+
+        bool operator() (Node & key, result_type & value) const {
+          if ( renumber[value] == SMT_Graph::none() ) return false;
+          for ( unsigned i = 0; i < key.arity; ++i ) {
+            key.args[i] = renumber[ key.args[i] ];
+          }
+          value = renumber[value];
+          return true;
+        }
+
+        template <typename Key>
+        bool operator() (Key const &, result_type & value) const {
+          if ( renumber[value] == SMT_Graph::none() ) return false;
+          value = renumber[value];
+          return true;
+        }
+
+        std::vector<result_type> const & renumber;
+      };
+
+      // renumbers a chain and moves its leaves from leaves to kept
+      struct RenumberChain {
+        RenumberChain( std::vector<result_type> const & renumber
+                     , std::vector<result_type> const & leaves
+                     , std::vector<result_type> & kept )
+          : renumber(renumber), leaves(leaves), kept(kept) {}
+
+        bool operator() (result_type & root, Chain & chain) const {
+          if ( renumber[root] == SMT_Graph::none() ) return false;
+          root = renumber[root];
+          const unsigned first = kept.size();
+          for ( unsigned i = 0; i < chain.size; ++i ) {
+            kept.push_back( renumber[ leaves[chain.first + i] ] );
+          }
+          chain.first = first;
+          return true;
+        }
+
+        std::vector<result_type> const & renumber;
+        std::vector<result_type> const & leaves;
+        std::vector<result_type> & kept;
+      };
+
     private:
       SMT_Graph _g;
 
@@ -355,21 +576,52 @@ namespace metaSMT {
         , boost::tuple< logic::QF_BV::tag::bvhex_tag, std::string >
       > ConstantOpT;
 
+      struct ConstantHash : boost::static_visitor<std::size_t> {
+        std::size_t operator() (nil const &) const { return 0; }
+
+        template <typename T, typename V, typename W>
+        std::size_t operator() (boost::tuple<T, V, W> const & c) const {
+          std::size_t seed = boost::hash_value( boost::get<1>(c) );
+          boost::hash_combine(seed, boost::get<2>(c));
+          return seed;
+        }
+
+        template <typename T>
+        std::size_t operator() (boost::tuple<T, std::string> const & c) const {
+          return boost::hash_value( boost::get<1>(c) );
+        }
+
+        std::size_t operator() (ConstantOpT const & c) const {
+          std::size_t seed = c.which();
+          boost::hash_combine(seed, boost::apply_visitor(*this, c));
+          return seed;
+        }
+      };
+
+      struct ConstantEqual {
+        bool operator() (ConstantOpT const & a, ConstantOpT const & b) const {
+          return !(a < b) && !(b < a);
+        }
+      };
+
       typedef std::tr1::unordered_map<unsigned, result_type> VariableLookupT;
-      typedef std::map< ConstantOpT, result_type> ConstantLookupT;
-      typedef std::map< Tag, result_type > Op0LookupT;
-      typedef std::map< boost::tuple<Tag, result_type>, result_type > Op1LookupT;
-      typedef std::map< boost::tuple<Tag, result_type, result_type>, result_type > Op2LookupT;
-      typedef std::map< boost::tuple<Tag, result_type, result_type, result_type>, result_type > Op3LookupT;
+      typedef UniqueTable< ConstantOpT, result_type, ConstantHash, ConstantEqual > ConstantLookupT;
+      typedef UniqueTable< Node, result_type, NodeHash, NodeEqual > NodeLookupT;
+      typedef UniqueTable< result_type, Chain, boost::hash<result_type> > ChainLookupT;
       VariableLookupT _variables;
       ConstantLookupT _constants;
-      Op0LookupT _op0Lookup;
-      Op1LookupT _op1Lookup;
-      Op2LookupT _op2Lookup;
-      Op3LookupT _op3Lookup;
+      NodeLookupT _nodes;
+      ChainLookupT _chains;
+      std::vector<result_type> _leaves;
      
   }; // Graph_Context
 
+  namespace features {
+    template<>
+    struct supports< Graph_Context, collect_garbage_cmd>
+    : boost::mpl::true_ {};
+  }
+
   template <typename Expr>
   SMT_Expression evaluate( Graph_Context & ctx, Expr const & e ) {
     // check(e);
@@ -0,0 +1,350 @@
+#pragma once
+
+#include "Aiger.hpp"
+#include "AigCuts.hpp"
+#include "../support/ClauseArena.hpp"
+
+#include <boost/tr1/unordered_map.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace metaSMT {
+  namespace aig {
+
+    /**
+     * a conjunction of leaves, bit i of pos (neg) is set if leaf i
+     * occurs positive (negative)
+     **/
+    struct Cube {
+      unsigned char pos;
+      unsigned char neg;
+    };
+
+    inline truth_table cofactor0 ( truth_table t, unsigned v )
+    {
+      const truth_table m = t & ~pattern ( v );
+      return m | ( m << ( 1u << v ) );
+    }
+
+    inline truth_table cofactor1 ( truth_table t, unsigned v )
+    {
+      const truth_table m = t & pattern ( v );
+      return m | ( m >> ( 1u << v ) );
+    }
+
+    /**
+     * irredundant sum of products (Minato-Morreale) of a function
+     * between lower and upper over the leaves [0, vars). The cubes are
+     * appended to cover, the function of the cover is returned.
+     **/
+    inline truth_table isop ( truth_table lower, truth_table upper, unsigned vars
+        , Cube const & cube, std::vector<Cube> & cover )
+    {
+      if ( lower == 0 )
+        return 0;
+      if ( upper == ~truth_table(0) || vars == 0 ) {
+        cover.push_back ( cube );
+        return ~truth_table(0);
+      }
+
+      // the top leaf the bounds depend on
+      unsigned v = vars;
+      truth_table l0, l1, u0, u1;
+      do {
+        --v;
+        l0 = cofactor0 ( lower, v );
+        l1 = cofactor1 ( lower, v );
+        u0 = cofactor0 ( upper, v );
+        u1 = cofactor1 ( upper, v );
+      } while ( v > 0 && l0 == l1 && u0 == u1 );
+
+      Cube c0 = cube;
+      c0.neg |= 1u << v;
+      Cube c1 = cube;
+      c1.pos |= 1u << v;
+      const truth_table r0 = isop ( l0 & ~u1, u0, v, c0, cover );
+      const truth_table r1 = isop ( l1 & ~u0, u1, v, c1, cover );
+      const truth_table rs = isop ( ( l0 & ~r0 ) | ( l1 & ~r1 ), u0 & u1, v, cube, cover );
+      return rs | ( r0 & ~pattern ( v ) ) | ( r1 & pattern ( v ) );
+    }
+
+  } // namespace aig
+
+  /**
+   * @brief cut-based CNF generation for an and-inverter graph.
+   *
+   * Instead of three clauses per and gate, the cone of the roots is
+   * covered by k-feasible cuts. Every gate gets its cuts enumerated and
+   * the cut with the lowest area flow (clauses of the cut plus the
+   * shared clauses of its leaves) is selected. Only the gates that are
+   * roots or leaves of selected cuts get clauses: the irredundant CNF of
+   * the truth table of their cut, so the gates inside a cut need no SAT
+   * variable.
+   *
+   * The graph is accessed through a Network with
+   *   bool gate ( unsigned var, result_type & rhs0, result_type & rhs1 )
+   *     the operands of the gate of var, false for inputs and gates
+   *     that are encoded already,
+   *   int literal ( result_type lit )
+   *     the SAT literal of lit.
+   **/
+  class AigCnf {
+    public:
+      typedef Aiger::result_type result_type;
+
+      AigCnf ()
+        : _cut_size ( 4 )
+      {}
+
+      /**
+       * the maximal number of leaves of a cut, at most
+       * aig::MAX_CUT_SIZE
+       **/
+      void cut_size ( unsigned k )
+      {
+        _cut_size = std::max ( 2u, std::min ( k, unsigned ( aig::MAX_CUT_SIZE ) ) );
+      }
+
+      /**
+       * appends the clauses of the cone of roots to clauses and the
+       * variables that got clauses to mapped
+       **/
+      template <typename Network>
+      void encode ( std::vector<result_type> const & roots, Network const & net
+          , SAT::ClauseArena & clauses, std::vector<unsigned> & mapped )
+      {
+        Nodes nodes;
+        std::vector<unsigned> order;
+        cone ( roots, net, nodes, order );
+        for ( unsigned i = 0; i < order.size(); ++i ) {
+          enumerate ( order[i], nodes );
+        }
+
+        std::vector<unsigned> pending;
+        for ( unsigned i = 0; i < roots.size(); ++i ) {
+          pending.push_back ( aiger_lit2var ( roots[i] ) );
+        }
+        while ( !pending.empty() ) {
+          const unsigned var = pending.back();
+          pending.pop_back();
+          Nodes::iterator it = nodes.find ( var );
+          if ( it == nodes.end() || it->second.mapped )
+            continue;
+          Node & node = it->second;
+          node.mapped = true;
+          mapped.push_back ( var );
+
+          aig::Cut const & cut = node.cuts[ node.best ];
+          emit ( var, cut, net, clauses );
+          for ( unsigned i = 0; i < cut.size; ++i ) {
+            pending.push_back ( cut.leaves[i] );
+          }
+        }
+      }
+
+    private:
+      /**
+       * the irredundant CNF of a table: y -> !off[i] and on[i] -> y
+       **/
+      struct Cnf {
+        std::vector<aig::Cube> on;
+        std::vector<aig::Cube> off;
+      };
+
+      struct Node {
+        Node ()
+          : rhs0 ( 0 ), rhs1 ( 0 ), refs ( 0 ), flow ( 0 ), best ( 0 ), mapped ( false )
+        {}
+
+        result_type rhs0;
+        result_type rhs1;
+        unsigned refs;
+        float flow;
+        // the trivial cut first, then the best cuts by area flow
+        std::vector<aig::Cut> cuts;
+        unsigned best;
+        bool mapped;
+      };
+
+      typedef std::tr1::unordered_map< unsigned, Node > Nodes;
+
+      // cuts kept per gate besides the trivial one
+      enum { MAX_CUTS = 8 };
+
+      /**
+       * collects the gates of the cone of roots in topological order and
+       * counts their references
+       **/
+      template <typename Network>
+      void cone ( std::vector<result_type> const & roots, Network const & net
+          , Nodes & nodes, std::vector<unsigned> & order )
+      {
+        // var and whether its operands are done
+        std::vector< std::pair<unsigned, bool> > pending;
+        for ( unsigned i = 0; i < roots.size(); ++i ) {
+          pending.push_back ( std::make_pair ( aiger_lit2var ( roots[i] ), false ) );
+        }
+        while ( !pending.empty() ) {
+          const std::pair<unsigned, bool> top = pending.back();
+          pending.pop_back();
+          if ( top.second ) {
+            order.push_back ( top.first );
+            continue;
+          }
+          Nodes::iterator it = nodes.find ( top.first );
+          if ( it != nodes.end() ) {
+            ++it->second.refs;
+            continue;
+          }
+          Node node;
+          if ( !net.gate ( top.first, node.rhs0, node.rhs1 ) )
+            continue;
+          node.refs = 1;
+          nodes.insert ( std::make_pair ( top.first, node ) );
+          pending.push_back ( std::make_pair ( top.first, true ) );
+          pending.push_back ( std::make_pair ( aiger_lit2var ( node.rhs0 ), false ) );
+          pending.push_back ( std::make_pair ( aiger_lit2var ( node.rhs1 ), false ) );
+        }
+      }
+
+      struct by_flow {
+        explicit by_flow ( std::vector<float> const & flows )
+          : flows ( flows )
+        {}
+
+        bool operator() ( unsigned a, unsigned b ) const
+        {
+          return flows[a] < flows[b];
+        }
+
+        std::vector<float> const & flows;
+      };
+
+      /**
+       * the cuts of var from the cuts of its operands, the best one by
+       * area flow becomes node.best
+       **/
+      void enumerate ( unsigned var, Nodes & nodes )
+      {
+        Node & node = nodes.find ( var )->second;
+        const result_type in[2] = { node.rhs0, node.rhs1 };
+
+        std::vector<aig::Cut> trivial[2];
+        std::vector<aig::Cut> const * operand[2];
+        for ( unsigned k = 0; k < 2; ++k ) {
+          Nodes::const_iterator it = nodes.find ( aiger_lit2var ( in[k] ) );
+          if ( it != nodes.end() ) {
+            operand[k] = &it->second.cuts;
+          } else {
+            trivial[k].push_back ( aig::trivial_cut ( aiger_lit2var ( in[k] ) ) );
+            operand[k] = &trivial[k];
+          }
+        }
+
+        std::vector<aig::Cut> candidates;
+        std::vector<float> flows;
+        for ( unsigned x = 0; x < operand[0]->size(); ++x ) {
+          for ( unsigned y = 0; y < operand[1]->size(); ++y ) {
+            aig::Cut c;
+            if ( !aig::and_cut ( (*operand[0])[x], aiger_sign ( in[0] )
+                  , (*operand[1])[y], aiger_sign ( in[1] ), c, _cut_size ) )
+              continue;
+            bool dominated = false;
+            for ( unsigned i = 0; i < candidates.size() && !dominated; ++i ) {
+              dominated = aig::dominates ( candidates[i], c );
+            }
+            if ( dominated )
+              continue;
+
+            float flow = cost ( c.table );
+            for ( unsigned i = 0; i < c.size; ++i ) {
+              Nodes::const_iterator it = nodes.find ( c.leaves[i] );
+              if ( it != nodes.end() )
+                flow += it->second.flow / it->second.refs;
+            }
+            candidates.push_back ( c );
+            flows.push_back ( flow );
+          }
+        }
+
+        std::vector<unsigned> ranks ( candidates.size() );
+        for ( unsigned i = 0; i < ranks.size(); ++i ) {
+          ranks[i] = i;
+        }
+        std::stable_sort ( ranks.begin(), ranks.end(), by_flow ( flows ) );
+        if ( ranks.size() > MAX_CUTS )
+          ranks.resize ( MAX_CUTS );
+
+        node.cuts.clear();
+        node.cuts.push_back ( aig::trivial_cut ( var ) );
+        for ( unsigned i = 0; i < ranks.size(); ++i ) {
+          node.cuts.push_back ( candidates[ ranks[i] ] );
+        }
+        // the cut of the two operands always exists
+        node.best = 1;
+        node.flow = flows[ ranks[0] ];
+      }
+
+      Cnf const & cnf ( aig::truth_table table )
+      {
+        std::tr1::unordered_map< aig::truth_table, Cnf >::iterator it = _cnfs.find ( table );
+        if ( it == _cnfs.end() ) {
+          Cnf c;
+          const aig::Cube empty = { 0, 0 };
+          aig::isop ( table, table, aig::MAX_CUT_SIZE, empty, c.on );
+          aig::isop ( ~table, ~table, aig::MAX_CUT_SIZE, empty, c.off );
+          it = _cnfs.insert ( std::make_pair ( table, c ) ).first;
+        }
+        return it->second;
+      }
+
+      unsigned cost ( aig::truth_table table )
+      {
+        Cnf const & c = cnf ( table );
+        return c.on.size() + c.off.size();
+      }
+
+      template <typename Network>
+      void emit ( unsigned var, aig::Cut const & cut, Network const & net
+          , SAT::ClauseArena & clauses )
+      {
+        SAT::tag::lit_tag out = { net.literal ( aiger_var2lit ( var ) ) };
+        Cnf const & c = cnf ( cut.table );
+        for ( unsigned i = 0; i < c.on.size(); ++i ) {
+          clause ( out, c.on[i], cut, net, clauses );
+        }
+        for ( unsigned i = 0; i < c.off.size(); ++i ) {
+          clause ( -out, c.off[i], cut, net, clauses );
+        }
+      }
+
+      /**
+       * the clause head | !cube over the leaves of cut
+       **/
+      template <typename Network>
+      void clause ( SAT::tag::lit_tag head, aig::Cube const & cube, aig::Cut const & cut
+          , Network const & net, SAT::ClauseArena & clauses )
+      {
+        _clause.clear();
+        _clause.push_back ( head );
+        for ( unsigned i = 0; i < cut.size; ++i ) {
+          SAT::tag::lit_tag leaf = { net.literal ( aiger_var2lit ( cut.leaves[i] ) ) };
+          if ( cube.pos & ( 1u << i ) )
+            _clause.push_back ( -leaf );
+          else if ( cube.neg & ( 1u << i ) )
+            _clause.push_back ( leaf );
+        }
+        clauses.push ( _clause );
+      }
+
+    private:
+      unsigned _cut_size;
+      // the CNF of each table seen so far
+      std::tr1::unordered_map< aig::truth_table, Cnf > _cnfs;
+      std::vector<SAT::tag::lit_tag> _clause;
+  };
+
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
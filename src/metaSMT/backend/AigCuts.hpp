@@ -0,0 +1,117 @@
+#pragma once
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+
+namespace metaSMT {
+  namespace aig {
+
+    typedef boost::uint64_t truth_table;
+
+    enum { MAX_CUT_SIZE = 6 };
+
+    /**
+     * a cut of at most MAX_CUT_SIZE leaves (sorted variables) and the
+     * truth table of the gate in terms of the leaves, leaf i is bit i of
+     * the table index. Tables of smaller cuts repeat in the upper bits.
+     **/
+    struct Cut {
+      unsigned size;
+      unsigned leaves[MAX_CUT_SIZE];
+      truth_table table;
+    };
+
+    // the table of leaf i
+    inline truth_table pattern ( unsigned i )
+    {
+      static const truth_table patterns[MAX_CUT_SIZE] = {
+          0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull
+        , 0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+      };
+      return patterns[i];
+    }
+
+    /**
+     * the cut of the single leaf var
+     **/
+    inline Cut trivial_cut ( unsigned var )
+    {
+      Cut c;
+      c.size = 1;
+      c.leaves[0] = var;
+      c.table = pattern ( 0 );
+      return c;
+    }
+
+    /**
+     * the table of cut c over the leaves of the larger cut to
+     **/
+    inline truth_table expand ( Cut const & c, Cut const & to )
+    {
+      unsigned position[MAX_CUT_SIZE];
+      for ( unsigned i = 0; i < c.size; ++i ) {
+        position[i] = std::find ( to.leaves, to.leaves + to.size, c.leaves[i] ) - to.leaves;
+      }
+      truth_table table = 0;
+      for ( unsigned m = 0; m < 64; ++m ) {
+        unsigned index = 0;
+        for ( unsigned i = 0; i < c.size; ++i ) {
+          index |= ( ( m >> position[i] ) & 1 ) << i;
+        }
+        table |= ( ( c.table >> index ) & 1 ) << m;
+      }
+      return table;
+    }
+
+    /**
+     * the union of the leaves of a and b in r, false if it has more than
+     * k leaves
+     **/
+    inline bool merge ( Cut const & a, Cut const & b, Cut & r, unsigned k )
+    {
+      unsigned i = 0, j = 0;
+      r.size = 0;
+      while ( i < a.size || j < b.size ) {
+        unsigned next;
+        if ( j == b.size || ( i < a.size && a.leaves[i] < b.leaves[j] ) ) {
+          next = a.leaves[i++];
+        } else if ( i == a.size || b.leaves[j] < a.leaves[i] ) {
+          next = b.leaves[j++];
+        } else {
+          next = a.leaves[i++];
+          ++j;
+        }
+        if ( r.size == k )
+          return false;
+        r.leaves[ r.size++ ] = next;
+      }
+      return true;
+    }
+
+    /**
+     * the cut of the and gate of the (optionally complemented) operand
+     * cuts a and b, false if it has more than k leaves
+     **/
+    inline bool and_cut ( Cut const & a, bool ca, Cut const & b, bool cb, Cut & r, unsigned k )
+    {
+      if ( !merge ( a, b, r, k ) )
+        return false;
+      const truth_table ta = expand ( a, r ) ^ ( ca ? ~truth_table(0) : 0 );
+      const truth_table tb = expand ( b, r ) ^ ( cb ? ~truth_table(0) : 0 );
+      r.table = ta & tb;
+      return true;
+    }
+
+    /**
+     * whether the leaves of a are a subset of the leaves of b
+     **/
+    inline bool dominates ( Cut const & a, Cut const & b )
+    {
+      return std::includes ( b.leaves, b.leaves + b.size, a.leaves, a.leaves + a.size );
+    }
+
+  } // namespace aig
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
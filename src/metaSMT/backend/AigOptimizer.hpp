@@ -0,0 +1,705 @@
+#pragma once
+
+#include "Aiger.hpp"
+#include "AigCuts.hpp"
+#include "AigSimulator.hpp"
+#include "../Features.hpp"
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/assert.hpp>
+#include <boost/tr1/unordered_map.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace metaSMT {
+
+  /**
+   * @brief counters reported by the AigOptimizer.
+   *
+   * before and after count the and gates in the optimized cones before
+   * and after the passes, balanced, rewritten and merged the gates
+   * replaced by the balance, rewrite and fraig passes. simulated counts
+   * the solves of SAT_Aiger answered by random simulation.
+   **/
+  struct AigStatistics {
+    AigStatistics()
+      : before(0), after(0), balanced(0), rewritten(0), merged(0)
+      , simulated(0)
+    {}
+
+    unsigned long before;
+    unsigned long after;
+    unsigned long balanced;
+    unsigned long rewritten;
+    unsigned long merged;
+    unsigned long simulated;
+  };
+
+  struct aig_statistics_cmd { typedef AigStatistics result_type; };
+
+  template <typename Context_ >
+  AigStatistics aig_statistics( Context_ &ctx ) {
+    BOOST_MPL_ASSERT_MSG(
+      ( features::supports<Context_, aig_statistics_cmd>::value )
+    , context_does_not_support_aig_statistics_api
+    , ()
+    );
+    return ctx.command(aig_statistics_cmd());
+  }
+
+  namespace aig {
+
+    /**
+     * @brief small DPLL solver for the miters of the fraig pass.
+     *
+     * Unit propagation over clauses of at most three literals and
+     * chronological backtracking. The search gives up after a given
+     * number of conflicts.
+     **/
+    class MiterSolver {
+      public:
+        enum Result { UNSAT, SAT, UNKNOWN };
+
+        MiterSolver ()
+          : _head ( 0 )
+        {}
+
+        // variables are numbered from 1
+        int new_var () {
+          _assign.push_back( 0 );
+          _occurs.resize( 2 * _assign.size() );
+          return _assign.size();
+        }
+
+        void clause ( int a, int b = 0, int c = 0 ) {
+          Clause cls = { { a, b, c } };
+          const unsigned index = _clauses.size();
+          _clauses.push_back( cls );
+          for ( unsigned i = 0; i < 3 && cls.lit[i] != 0; ++i ) {
+            _occurs[ slot( cls.lit[i] ) ].push_back( index );
+          }
+        }
+
+        Result solve ( std::vector<int> const & assumptions, unsigned max_conflicts ) {
+          std::fill( _assign.begin(), _assign.end(), 0 );
+          _trail.clear();
+          _head = 0;
+
+          for ( unsigned i = 0; i < _clauses.size(); ++i ) {
+            if ( _clauses[i].lit[1] == 0 && !enqueue( _clauses[i].lit[0] ) )
+              return UNSAT;
+          }
+          for ( unsigned i = 0; i < assumptions.size(); ++i ) {
+            if ( !enqueue( assumptions[i] ) )
+              return UNSAT;
+          }
+          if ( !propagate() )
+            return UNSAT;
+
+          // trail position of each decision and whether it was flipped
+          std::vector< std::pair<unsigned, bool> > decisions;
+          unsigned conflicts = 0;
+          for (;;) {
+            int var = 1;
+            while ( var <= int(_assign.size()) && _assign[var-1] != 0 )
+              ++var;
+            if ( var > int(_assign.size()) )
+              return SAT;
+
+            decisions.push_back( std::make_pair( unsigned(_trail.size()), false ) );
+            enqueue( -var );
+            while ( !propagate() ) {
+              if ( ++conflicts > max_conflicts )
+                return UNKNOWN;
+              while ( !decisions.empty() && decisions.back().second ) {
+                undo( decisions.back().first );
+                decisions.pop_back();
+              }
+              if ( decisions.empty() )
+                return UNSAT;
+              const int decided = _trail[ decisions.back().first ];
+              undo( decisions.back().first );
+              decisions.back().second = true;
+              enqueue( -decided );
+            }
+          }
+        }
+
+      private:
+        struct Clause { int lit[3]; };
+
+        static unsigned slot ( int lit ) {
+          return 2 * ( std::abs(lit) - 1 ) + ( lit < 0 );
+        }
+
+        int value ( int lit ) const {
+          const int v = _assign[ std::abs(lit) - 1 ];
+          return lit > 0 ? v : -v;
+        }
+
+        bool enqueue ( int lit ) {
+          const int v = value( lit );
+          if ( v != 0 )
+            return v > 0;
+          _assign[ std::abs(lit) - 1 ] = lit > 0 ? 1 : -1;
+          _trail.push_back( lit );
+          return true;
+        }
+
+        void undo ( unsigned position ) {
+          for ( unsigned i = position; i < _trail.size(); ++i ) {
+            _assign[ std::abs(_trail[i]) - 1 ] = 0;
+          }
+          _trail.resize( position );
+          _head = position;
+        }
+
+        bool propagate () {
+          while ( _head < _trail.size() ) {
+            // the clauses that contain the negation of the assigned literal
+            std::vector<unsigned> const & occurs = _occurs[ slot( -_trail[_head++] ) ];
+            for ( unsigned i = 0; i < occurs.size(); ++i ) {
+              Clause const & cls = _clauses[ occurs[i] ];
+              unsigned open = 0;
+              int unit = 0;
+              bool satisfied = false;
+              for ( unsigned k = 0; k < 3 && cls.lit[k] != 0; ++k ) {
+                const int v = value( cls.lit[k] );
+                if ( v > 0 ) { satisfied = true; break; }
+                if ( v == 0 ) { ++open; unit = cls.lit[k]; }
+              }
+              if ( satisfied ) continue;
+              if ( open == 0 ) return false;
+              if ( open == 1 ) enqueue( unit );
+            }
+          }
+          return true;
+        }
+
+      private:
+        std::vector<Clause> _clauses;
+        std::vector< std::vector<unsigned> > _occurs;
+        std::vector<signed char> _assign;
+        std::vector<int> _trail;
+        unsigned _head;
+    };
+
+  } // namespace aig
+
+  /**
+   * @brief optimization passes on the and gates of an Aiger.
+   *
+   * The passes work on the cones of the given roots and never change an
+   * existing gate. They record for a gate an equivalent literal instead,
+   * resolve() follows these replacements. Gates marked as fixed (already
+   * encoded) are treated as inputs. All passes first rehash the cone on
+   * the replaced operands, which propagates constants and merges gates
+   * that became structurally equal.
+   *
+   *   balance: rebuilds trees of single fanout and gates with minimal depth
+   *   rewrite: replaces a gate by a constant, an input or a single and
+   *     gate if one of its 4-input cuts computes such a function
+   *   fraig:   merges gates with equal simulation signatures that a
+   *     small SAT check proves equivalent
+   **/
+  class AigOptimizer {
+    public:
+      typedef Aiger::result_type result_type;
+
+      AigOptimizer ( Aiger & aiger )
+        : _aiger ( aiger )
+        , _balance ( false )
+        , _rewrite ( false )
+        , _fraig ( false )
+        , _conflicts ( 100 )
+        , _sim ( aiger )
+      {}
+
+      /**
+       * passes is a comma separated list of balance, rewrite and fraig,
+       * conflicts bounds each SAT check of the fraig pass
+       **/
+      void configure ( std::string const & passes, unsigned conflicts )
+      {
+        std::vector<std::string> names;
+        boost::split( names, passes, boost::is_any_of(", "), boost::token_compress_on );
+        _balance = std::find( names.begin(), names.end(), "balance" ) != names.end();
+        _rewrite = std::find( names.begin(), names.end(), "rewrite" ) != names.end();
+        _fraig = std::find( names.begin(), names.end(), "fraig" ) != names.end();
+        _conflicts = conflicts;
+      }
+
+      bool enabled () const { return _balance || _rewrite || _fraig; }
+
+      AigStatistics const & statistics () const { return _stats; }
+
+      /**
+       * the literal that replaces lit
+       **/
+      result_type resolve ( result_type lit ) const
+      {
+        unsigned var = aiger_lit2var ( lit );
+        while ( var < _repl.size() && _repl[var] != aiger_var2lit ( var ) ) {
+          lit = _repl[var] ^ aiger_sign ( lit );
+          var = aiger_lit2var ( lit );
+        }
+        return lit;
+      }
+
+      /**
+       * runs the configured passes on the cones of roots. fixed[v] marks
+       * the variables whose gates must not be replaced.
+       **/
+      void optimize ( std::vector<result_type> const & roots, std::vector<bool> const & fixed )
+      {
+        std::vector<unsigned> order;
+        cone ( roots, fixed, order );
+        _stats.before += order.size();
+        if ( _balance ) {
+          balance ( roots, fixed, order );
+          cone ( roots, fixed, order );
+        }
+        if ( _rewrite ) {
+          rewrite ( fixed, order );
+          cone ( roots, fixed, order );
+        }
+        if ( _fraig ) {
+          fraig ( fixed, order );
+          cone ( roots, fixed, order );
+        }
+        _stats.after += order.size();
+      }
+
+    private:
+      /**
+       * records r as replacement of the gate var unless that would
+       * replace the gate by itself
+       **/
+      bool replace ( unsigned var, result_type r )
+      {
+        r = resolve ( r );
+        if ( aiger_lit2var ( r ) == var )
+          return false;
+        while ( _repl.size() <= var )
+          _repl.push_back ( aiger_var2lit ( _repl.size() ) );
+        _repl[var] = r;
+        return true;
+      }
+
+      /**
+       * the replaced operands of the gate of var, false for inputs and
+       * fixed gates
+       **/
+      bool gate ( unsigned var, std::vector<bool> const & fixed, result_type & a, result_type & b ) const
+      {
+        if ( var < fixed.size() && fixed[var] )
+          return false;
+        if ( !_aiger.fanins ( aiger_var2lit ( var ), a, b ) )
+          return false;
+        a = resolve ( a );
+        b = resolve ( b );
+        return true;
+      }
+
+      /**
+       * the gates of the cones of roots in topological order. Gates with
+       * replaced operands are rehashed first.
+       **/
+      void cone ( std::vector<result_type> const & roots, std::vector<bool> const & fixed
+          , std::vector<unsigned> & order )
+      {
+        order.clear();
+        std::vector<char> visited ( _aiger.aig->maxvar + 1, 0 );
+        // variable and whether its operands are visited
+        std::vector< std::pair<unsigned, bool> > pending;
+        for ( unsigned i = 0; i < roots.size(); ++i ) {
+          pending.push_back ( std::make_pair ( aiger_lit2var ( resolve ( roots[i] ) ), false ) );
+        }
+
+        while ( !pending.empty() ) {
+          const unsigned var = pending.back().first;
+          result_type a, b;
+          if ( pending.back().second ) {
+            pending.pop_back();
+            result_type ra, rb;
+            if ( !_aiger.fanins ( aiger_var2lit ( var ), ra, rb )
+              || !gate ( var, fixed, a, b )
+              || ( a == ra && b == rb ) ) {
+              order.push_back ( var );
+              continue;
+            }
+            const result_type r = _aiger.add_and ( a, b );
+            if ( !replace ( var, r ) ) {
+              order.push_back ( var );
+              continue;
+            }
+            // the rehashed gate takes the place of var
+            const unsigned rvar = aiger_lit2var ( resolve ( r ) );
+            if ( visited.size() <= rvar )
+              visited.resize ( rvar + 1, 0 );
+            if ( !visited[rvar] && gate ( rvar, fixed, a, b ) ) {
+              visited[rvar] = 1;
+              order.push_back ( rvar );
+            }
+            continue;
+          }
+
+          if ( visited.size() <= var )
+            visited.resize ( var + 1, 0 );
+          if ( visited[var] || !gate ( var, fixed, a, b ) ) {
+            visited[var] = 1;
+            pending.pop_back();
+            continue;
+          }
+          visited[var] = 1;
+          pending.back().second = true;
+          pending.push_back ( std::make_pair ( aiger_lit2var ( a ), false ) );
+          pending.push_back ( std::make_pair ( aiger_lit2var ( b ), false ) );
+        }
+      }
+
+      unsigned level ( result_type lit ) const
+      {
+        const unsigned var = aiger_lit2var ( lit );
+        return var < _levels.size() ? _levels[var] : 0;
+      }
+
+      void set_level ( result_type lit, unsigned l )
+      {
+        const unsigned var = aiger_lit2var ( lit );
+        if ( _levels.size() <= var )
+          _levels.resize ( var + 1, 0 );
+        _levels[var] = l;
+      }
+
+      /**
+       * rebuilds each maximal tree of positive, single fanout and gates
+       * as a tree of minimal depth, combining the shallowest operands
+       * first
+       **/
+      void balance ( std::vector<result_type> const & roots, std::vector<bool> const & fixed
+          , std::vector<unsigned> const & order )
+      {
+        const unsigned size = _aiger.aig->maxvar + 1;
+        std::vector<unsigned> refs ( size, 0 );
+        std::vector<char> positive ( size, 0 );
+        std::vector<char> in_cone ( size, 0 );
+        for ( unsigned i = 0; i < roots.size(); ++i ) {
+          // referenced from outside of the cone
+          refs[ aiger_lit2var ( resolve ( roots[i] ) ) ] += 2;
+        }
+        for ( unsigned i = 0; i < order.size(); ++i ) {
+          result_type in[2];
+          gate ( order[i], fixed, in[0], in[1] );
+          in_cone[ order[i] ] = 1;
+          for ( unsigned k = 0; k < 2; ++k ) {
+            ++refs[ aiger_lit2var ( in[k] ) ];
+            positive[ aiger_lit2var ( in[k] ) ] = !aiger_sign ( in[k] );
+          }
+        }
+
+        _levels.clear();
+        for ( unsigned i = 0; i < order.size(); ++i ) {
+          const unsigned var = order[i];
+          result_type in[2];
+          gate ( var, fixed, in[0], in[1] );
+          const unsigned old_level = 1 + std::max ( level ( in[0] ), level ( in[1] ) );
+          set_level ( aiger_var2lit ( var ), old_level );
+
+          // inner gates of a tree are handled with its root
+          if ( refs[var] == 1 && positive[var] )
+            continue;
+
+          std::vector<result_type> leaves;
+          std::vector<result_type> pending ( in, in + 2 );
+          while ( !pending.empty() ) {
+            const result_type lit = pending.back();
+            pending.pop_back();
+            const unsigned v = aiger_lit2var ( lit );
+            result_type a, b;
+            if ( !aiger_sign ( lit ) && v < size && in_cone[v] && refs[v] == 1
+                && positive[v] && gate ( v, fixed, a, b ) ) {
+              pending.push_back ( a );
+              pending.push_back ( b );
+            } else {
+              leaves.push_back ( lit );
+            }
+          }
+          if ( leaves.size() <= 2 )
+            continue;
+
+          std::sort ( leaves.begin(), leaves.end() );
+          leaves.erase ( std::unique ( leaves.begin(), leaves.end() ), leaves.end() );
+          bool contradiction = false;
+          for ( unsigned k = 0; k + 1 < leaves.size(); ++k ) {
+            // x and !x are adjacent after sorting
+            contradiction = contradiction || leaves[k+1] == aiger_not ( leaves[k] );
+          }
+          if ( contradiction ) {
+            leaves.assign ( 1, aiger_false );
+          }
+
+          typedef std::pair<unsigned, result_type> Entry;
+          std::priority_queue< Entry, std::vector<Entry>, std::greater<Entry> > queue;
+          for ( unsigned k = 0; k < leaves.size(); ++k ) {
+            queue.push ( Entry ( level ( leaves[k] ), leaves[k] ) );
+          }
+          while ( queue.size() > 1 ) {
+            const Entry x = queue.top(); queue.pop();
+            const Entry y = queue.top(); queue.pop();
+            const result_type r = _aiger.add_and ( x.second, y.second );
+            if ( aiger_lit2var ( r ) >= size || level ( r ) == 0 )
+              set_level ( r, 1 + std::max ( x.first, y.first ) );
+            queue.push ( Entry ( level ( r ), r ) );
+          }
+
+          const result_type r = queue.top().second;
+          if ( level ( r ) < old_level && replace ( var, r ) ) {
+            ++_stats.balanced;
+            set_level ( aiger_var2lit ( var ), level ( r ) );
+          }
+        }
+      }
+
+      typedef aig::Cut Cut;
+      typedef aig::truth_table truth_table;
+
+      /**
+       * a literal for the function table of the leaves of c that needs
+       * at most one and gate
+       **/
+      bool simple ( Cut const & c, truth_table table, result_type & r )
+      {
+        using aig::pattern;
+        if ( table == 0 ) { r = aiger_false; return true; }
+        if ( table == ~truth_table(0) ) { r = aiger_true; return true; }
+        for ( unsigned i = 0; i < c.size; ++i ) {
+          const result_type leaf = aiger_var2lit ( c.leaves[i] );
+          if ( table == pattern(i) ) { r = leaf; return true; }
+          if ( table == ~pattern(i) ) { r = aiger_not ( leaf ); return true; }
+        }
+        for ( unsigned i = 0; i < c.size; ++i ) {
+          for ( unsigned j = i + 1; j < c.size; ++j ) {
+            for ( unsigned p = 0; p < 4; ++p ) {
+              const truth_table pi = ( p & 1 ) ? ~pattern(i) : pattern(i);
+              const truth_table pj = ( p & 2 ) ? ~pattern(j) : pattern(j);
+              const truth_table f = pi & pj;
+              if ( table != f && table != ~f )
+                continue;
+              r = _aiger.add_and ( aiger_var2lit ( c.leaves[i] ) ^ ( p & 1 )
+                  , aiger_var2lit ( c.leaves[j] ) ^ ( ( p >> 1 ) & 1 ) );
+              if ( table != f )
+                r = aiger_not ( r );
+              return true;
+            }
+          }
+        }
+        return false;
+      }
+
+      /**
+       * enumerates the 4-input cuts of the gates and replaces a gate by
+       * the simple function one of them computes
+       **/
+      void rewrite ( std::vector<bool> const & fixed, std::vector<unsigned> const & order )
+      {
+        // cuts per gate, at most this many besides the trivial one
+        const unsigned max_cuts = 8;
+        std::tr1::unordered_map< unsigned, std::vector<Cut> > cuts;
+
+        for ( unsigned i = 0; i < order.size(); ++i ) {
+          const unsigned var = order[i];
+          result_type in[2], raw[2];
+          // order only holds gates
+          if ( !gate ( var, fixed, in[0], in[1] )
+            || !_aiger.fanins ( aiger_var2lit ( var ), raw[0], raw[1] ) )
+            continue;
+          if ( in[0] != raw[0] || in[1] != raw[1] ) {
+            // an operand was rewritten, rehash the gate on the new one
+            replace ( var, _aiger.add_and ( in[0], in[1] ) );
+          }
+
+          std::vector<Cut> const * operand[2];
+          std::vector<Cut> trivial[2];
+          for ( unsigned k = 0; k < 2; ++k ) {
+            std::tr1::unordered_map< unsigned, std::vector<Cut> >::const_iterator it
+              = cuts.find ( aiger_lit2var ( in[k] ) );
+            if ( it != cuts.end() ) {
+              operand[k] = &it->second;
+            } else {
+              trivial[k].push_back ( aig::trivial_cut ( aiger_lit2var ( in[k] ) ) );
+              operand[k] = &trivial[k];
+            }
+          }
+
+          std::vector<Cut> & own = cuts[var];
+          own.push_back ( aig::trivial_cut ( var ) );
+          bool replaced = false;
+          for ( unsigned x = 0; x < operand[0]->size() && !replaced; ++x ) {
+            for ( unsigned y = 0; y < operand[1]->size() && !replaced; ++y ) {
+              Cut const & a = (*operand[0])[x];
+              Cut const & b = (*operand[1])[y];
+              Cut c;
+              if ( !aig::and_cut ( a, aiger_sign ( in[0] ), b, aiger_sign ( in[1] ), c, 4 ) )
+                continue;
+
+              // the cut of the operands is the gate itself
+              const bool operands = a.size == 1 && b.size == 1;
+              result_type r;
+              if ( !operands && simple ( c, c.table, r ) && replace ( var, r ) ) {
+                ++_stats.rewritten;
+                replaced = true;
+              } else if ( own.size() <= max_cuts ) {
+                own.push_back ( c );
+              }
+            }
+          }
+          if ( replaced ) {
+            // gates above use the cuts of the replacement
+            cuts.erase ( var );
+          }
+        }
+      }
+
+      /**
+       * checks a == b with the MiterSolver
+       **/
+      bool equivalent ( result_type a, result_type b, std::vector<bool> const & fixed )
+      {
+        aig::MiterSolver solver;
+        std::tr1::unordered_map< unsigned, int > vars;
+        std::vector<unsigned> pending;
+        pending.push_back ( aiger_lit2var ( a ) );
+        pending.push_back ( aiger_lit2var ( b ) );
+        // bound on the size of the miter
+        const unsigned max_gates = 4096;
+        unsigned gates = 0;
+        while ( !pending.empty() ) {
+          const unsigned var = pending.back();
+          pending.pop_back();
+          if ( vars.count ( var ) )
+            continue;
+          const int out = solver.new_var();
+          vars[var] = out;
+          result_type x, y;
+          if ( var == 0 ) {
+            solver.clause ( -out );
+          } else if ( gate ( var, fixed, x, y ) ) {
+            if ( ++gates > max_gates )
+              return false;
+            pending.push_back ( aiger_lit2var ( x ) );
+            pending.push_back ( aiger_lit2var ( y ) );
+          }
+        }
+        for ( std::tr1::unordered_map< unsigned, int >::const_iterator it = vars.begin();
+            it != vars.end(); ++it ) {
+          result_type x, y;
+          if ( it->first == 0 || !gate ( it->first, fixed, x, y ) )
+            continue;
+          const int out = it->second;
+          const int lx = literal ( vars, x );
+          const int ly = literal ( vars, y );
+          solver.clause ( -out, lx );
+          solver.clause ( -out, ly );
+          solver.clause ( out, -lx, -ly );
+        }
+
+        std::vector<int> assumptions ( 2 );
+        assumptions[0] = literal ( vars, a );
+        assumptions[1] = -literal ( vars, b );
+        if ( solver.solve ( assumptions, _conflicts ) != aig::MiterSolver::UNSAT )
+          return false;
+        assumptions[0] = -assumptions[0];
+        assumptions[1] = -assumptions[1];
+        return solver.solve ( assumptions, _conflicts ) == aig::MiterSolver::UNSAT;
+      }
+
+      static int literal ( std::tr1::unordered_map< unsigned, int > const & vars, result_type lit )
+      {
+        const int v = vars.find ( aiger_lit2var ( lit ) )->second;
+        return aiger_sign ( lit ) ? -v : v;
+      }
+
+      /**
+       * simulates the cone on random patterns and merges each gate into
+       * an earlier gate or constant with the same signature (up to
+       * complement) if they are proven equivalent
+       **/
+      void fraig ( std::vector<bool> const & fixed, std::vector<unsigned> const & order )
+      {
+        typedef AigSimulator::Word Word;
+        enum { WORDS = AigSimulator::WORDS };
+        // gates by the hash of their normalized signature
+        std::tr1::unordered_map< Word, std::vector<unsigned> > classes;
+        _sim.update();
+
+        for ( unsigned i = 0; i < order.size(); ++i ) {
+          const unsigned var = order[i];
+          const result_type self = aiger_var2lit ( var );
+          Word const * sig = _sim.patterns ( self );
+
+          // normalize to a 0 in the first pattern
+          const unsigned phase = sig[0] & 1;
+          Word hash = 0;
+          bool zero = true;
+          for ( unsigned w = 0; w < WORDS; ++w ) {
+            const Word n = phase ? ~sig[w] : sig[w];
+            hash = hash * 0x100000001B3ull ^ n;
+            zero = zero && n == 0;
+          }
+
+          if ( zero && equivalent ( self, aiger_false ^ phase, fixed ) ) {
+            if ( replace ( var, aiger_false ^ phase ) )
+              ++_stats.merged;
+            continue;
+          }
+
+          std::vector<unsigned> & members = classes[hash];
+          bool merged = false;
+          // only try the first candidates of a class
+          for ( unsigned m = 0; m < members.size() && m < 2 && !merged; ++m ) {
+            Word const * other = _sim.patterns ( aiger_var2lit ( members[m] ) );
+            const unsigned other_phase = other[0] & 1;
+            const Word flip = phase != other_phase ? ~Word(0) : 0;
+            bool same = true;
+            for ( unsigned w = 0; w < WORDS && same; ++w ) {
+              same = sig[w] == ( other[w] ^ flip );
+            }
+            const result_type candidate = aiger_var2lit ( members[m] ) ^ ( phase != other_phase );
+            if ( same && equivalent ( self, candidate, fixed ) && replace ( var, candidate ) ) {
+              ++_stats.merged;
+              merged = true;
+            }
+          }
+          if ( !merged )
+            members.push_back ( var );
+        }
+      }
+
+    private:
+      Aiger & _aiger;
+      bool _balance;
+      bool _rewrite;
+      bool _fraig;
+      unsigned _conflicts;
+      AigStatistics _stats;
+      // replacement literal of each variable, the variable itself if
+      // there is none
+      std::vector<result_type> _repl;
+      // depth of the gates during balance
+      std::vector<unsigned> _levels;
+      // signatures of the fraig pass
+      AigSimulator _sim;
+  };
+
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Aiger.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace metaSMT {
+  namespace aig {
+
+    typedef boost::uint64_t sim_word;
+
+    /**
+     * dst[i] = ( a[i] ^ ma ) & ( b[i] ^ mb ) for n words, the masks are
+     * 0 or ~0 and complement the operands. Uses AVX2 if the compiler
+     * targets it (e.g. -mavx2) and plain 64 bit operations otherwise.
+     **/
+    inline void and_words ( sim_word * dst
+        , sim_word const * a, sim_word ma
+        , sim_word const * b, sim_word mb
+        , unsigned n )
+    {
+      unsigned i = 0;
+#if defined(__AVX2__)
+      const __m256i va = _mm256_set1_epi64x ( static_cast<long long> ( ma ) );
+      const __m256i vb = _mm256_set1_epi64x ( static_cast<long long> ( mb ) );
+      for ( ; i + 4 <= n; i += 4 ) {
+        const __m256i x = _mm256_xor_si256 ( _mm256_loadu_si256 ( reinterpret_cast<__m256i const *> ( a + i ) ), va );
+        const __m256i y = _mm256_xor_si256 ( _mm256_loadu_si256 ( reinterpret_cast<__m256i const *> ( b + i ) ), vb );
+        _mm256_storeu_si256 ( reinterpret_cast<__m256i *> ( dst + i ), _mm256_and_si256 ( x, y ) );
+      }
+#endif
+      for ( ; i < n; ++i ) {
+        dst[i] = ( a[i] ^ ma ) & ( b[i] ^ mb );
+      }
+    }
+
+  } // namespace aig
+
+  /**
+   * @brief bit-parallel random simulation of an Aiger.
+   *
+   * Every variable holds WORDS * 64 patterns. The inputs get random
+   * patterns, the and gates are evaluated in one sweep over
+   * aig->ands, which is in topological order. Gates added later are
+   * simulated by the next call to update on the same patterns.
+   **/
+  class AigSimulator {
+    public:
+      typedef Aiger::result_type result_type;
+      typedef aig::sim_word Word;
+
+      enum { WORDS = 4, PATTERNS = WORDS * 64 };
+
+      AigSimulator ( Aiger const & aiger )
+        : _aiger ( aiger )
+        , _seed ( 0x9E3779B97F4A7C15ull )
+        , _simulated ( 0 )
+      {}
+
+      /**
+       * draws new patterns for all inputs, the gates are simulated
+       * again by the next update
+       **/
+      void randomize ()
+      {
+        for ( unsigned i = 0; i < _words.size(); ++i ) {
+          _words[i] = next();
+        }
+        zero_constant();
+        _simulated = 0;
+      }
+
+      /**
+       * simulates the gates added since the last update, new inputs get
+       * random patterns
+       **/
+      void update ()
+      {
+        const std::size_t size = ( _aiger.aig->maxvar + 1 ) * WORDS;
+        for ( std::size_t i = _words.size(); i < size; ++i ) {
+          _words.push_back ( next() );
+        }
+        zero_constant();
+
+        for ( ; _simulated < _aiger.aig->num_ands; ++_simulated ) {
+          aiger_and const & g = _aiger.aig->ands[_simulated];
+          aig::and_words ( words ( g.lhs ), words ( g.rhs0 ), mask ( g.rhs0 )
+              , words ( g.rhs1 ), mask ( g.rhs1 ), WORDS );
+        }
+      }
+
+      /**
+       * the patterns of the variable of lit, not complemented
+       **/
+      Word const * patterns ( result_type lit ) const
+      {
+        return &_words[ aiger_lit2var ( lit ) * WORDS ];
+      }
+
+      // whether update covered the variable of lit
+      bool simulated ( result_type lit ) const
+      {
+        return ( aiger_lit2var ( lit ) + 1 ) * WORDS <= _words.size();
+      }
+
+      bool value ( result_type lit, unsigned pattern ) const
+      {
+        const bool v = ( patterns ( lit )[pattern / 64] >> ( pattern % 64 ) ) & 1;
+        return aiger_sign ( lit ) ? !v : v;
+      }
+
+      /**
+       * a pattern that sets all literals in [first, last) to true,
+       * -1 if there is none
+       **/
+      template <typename Iterator>
+      int satisfying ( Iterator first, Iterator last ) const
+      {
+        Word all[WORDS];
+        for ( unsigned w = 0; w < WORDS; ++w ) {
+          all[w] = ~Word(0);
+        }
+        for ( ; first != last; ++first ) {
+          aig::and_words ( all, all, 0, patterns ( *first ), mask ( *first ), WORDS );
+        }
+        for ( unsigned w = 0; w < WORDS; ++w ) {
+          for ( unsigned b = 0; all[w] != 0 && b < 64; ++b ) {
+            if ( ( all[w] >> b ) & 1 )
+              return w * 64 + b;
+          }
+        }
+        return -1;
+      }
+
+    private:
+      Word * words ( result_type lit )
+      {
+        return &_words[ aiger_lit2var ( lit ) * WORDS ];
+      }
+
+      static Word mask ( result_type lit )
+      {
+        return aiger_sign ( lit ) ? ~Word(0) : Word(0);
+      }
+
+      void zero_constant ()
+      {
+        for ( unsigned w = 0; w < WORDS && w < _words.size(); ++w ) {
+          _words[w] = 0;
+        }
+      }
+
+      // xorshift64
+      Word next ()
+      {
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 7;
+        _seed ^= _seed << 17;
+        return _seed;
+      }
+
+    private:
+      Aiger const & _aiger;
+      Word _seed;
+      // WORDS words of patterns per variable
+      std::vector<Word> _words;
+      // aig->ands[0, _simulated) are simulated
+      unsigned _simulated;
+  };
+
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
@@ -4,6 +4,11 @@
 #include "../tags/Logic.hpp" 
 
 #include <boost/any.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/tr1/unordered_map.hpp>
+
+#include <utility>
+#include <vector>
 
 extern "C" {
 #include <aiger.h>
@@ -11,6 +16,15 @@ extern "C" {
 
 namespace metaSMT 
 {
+  /**
+   * And-inverter graph built in an aiger structure, so it can be written
+   * out with the aiger library.
+   *
+   * The and gates are structurally hashed: the operands are ordered, a
+   * unique table returns the existing gate for a repeated pair and
+   * one-level rules fold constant and trivially related operands
+   * (x&x, x&!x, x&true, x&(x&y), x&!(!x&y), ...) without a new gate.
+   **/
   class Aiger  
   {
     public:
@@ -47,16 +61,12 @@ namespace metaSMT
 
       result_type operator() (logic::tag::and_tag const&, result_type lhs, result_type rhs )
       {
-        result_type t = new_var();
-        aiger_add_and ( aig, t, lhs, rhs );
-        return t; 
+        return add_and ( lhs, rhs );
       }
 
       result_type operator() (logic::tag::nand_tag const&, result_type lhs, result_type rhs )
       {
-        result_type t = new_var();
-        aiger_add_and ( aig, t, lhs, rhs );
-        return aiger_not ( t );
+        return aiger_not ( add_and ( lhs, rhs ) );
       }
 
       result_type operator() (logic::tag::equal_tag const&, result_type lhs, result_type rhs )
@@ -129,9 +139,7 @@ namespace metaSMT
        
       unsigned aiger_add_or ( aiger *aig, unsigned lhs, unsigned rhs )
       {
-        result_type t = new_var ();
-        aiger_add_and ( aig, t, aiger_not (lhs), aiger_not (rhs) ); 
-        return aiger_not ( t );  
+        return aiger_not ( add_and ( aiger_not (lhs), aiger_not (rhs) ) );
       }
 
       unsigned aiger_add_xor ( aiger *aig, unsigned lhs, unsigned rhs )
@@ -141,24 +149,104 @@ namespace metaSMT
 
       unsigned aiger_add_xnor ( aiger *aig, unsigned lhs, unsigned rhs )
       {
-        result_type t1 = new_var ();
-        result_type t2 = new_var ();
-
-        aiger_add_and ( aig, t1, aiger_not ( lhs ), aiger_not ( rhs ) ); 
-        aiger_add_and ( aig, t2, lhs, rhs ); 
+        result_type t1 = add_and ( aiger_not ( lhs ), aiger_not ( rhs ) );
+        result_type t2 = add_and ( lhs, rhs );
 
         return aiger_add_or ( aig, t1, t2 ); 
       }
 
       unsigned aiger_add_ite ( aiger *aig, unsigned I, unsigned T, unsigned E )
       {
-        result_type t = new_var (); 
-        aiger_add_and ( aig 
-            , t
-            , aiger_add_or ( aig, aiger_not (I), T )
+        return add_and ( aiger_add_or ( aig, aiger_not (I), T )
             , aiger_add_or ( aig, I, E ) );
+      }
+
+      /**
+       * the and of lhs and rhs, an existing or simplified literal if
+       * possible, otherwise a new gate
+       **/
+      result_type add_and ( result_type lhs, result_type rhs )
+      {
+        if ( lhs > rhs )
+          std::swap ( lhs, rhs );
+
+        // constants are the smallest literals
+        if ( lhs == aiger_false )
+          return aiger_false;
+        if ( lhs == aiger_true )
+          return rhs;
+        if ( lhs == rhs )
+          return lhs;
+        if ( lhs == aiger_not ( rhs ) )
+          return aiger_false;
+
+        result_type r;
+        if ( simplify ( lhs, rhs, r ) || simplify ( rhs, lhs, r ) )
+          return r;
+
+        const boost::uint64_t key = ( boost::uint64_t ( lhs ) << 32 ) | rhs;
+        UniqueTable::const_iterator it = _unique.find ( key );
+        if ( it != _unique.end() )
+          return it->second;
+
+        result_type t = new_var ();
+        aiger_add_and ( aig, t, lhs, rhs );
+        _unique.insert ( std::make_pair ( key, t ) );
+        if ( _fanins.size() <= aiger_lit2var ( t ) )
+          _fanins.resize ( aiger_lit2var ( t ) + 1, std::make_pair ( aiger_false, aiger_false ) );
+        _fanins[ aiger_lit2var ( t ) ] = std::make_pair ( lhs, rhs );
         return t;
       }
+
+      /**
+       * the operands of the and gate of lit, false for inputs and
+       * constants
+       **/
+      bool fanins ( result_type lit, result_type & rhs0, result_type & rhs1 ) const
+      {
+        const unsigned var = aiger_lit2var ( lit );
+        if ( var >= _fanins.size() || _fanins[var].first == aiger_false )
+          return false;
+        rhs0 = _fanins[var].first;
+        rhs1 = _fanins[var].second;
+        return true;
+      }
+
+    private:
+      /**
+       * one-level rules for x & g where g is an and gate, possibly negated
+       **/
+      bool simplify ( result_type x, result_type g, result_type & r ) const
+      {
+        const unsigned var = aiger_lit2var ( g );
+        if ( var >= _fanins.size() || _fanins[var].first == aiger_false )
+          return false;
+
+        const result_type a = _fanins[var].first;
+        const result_type b = _fanins[var].second;
+        if ( !aiger_sign ( g ) )
+        {
+          // x & (x & b) = x & b
+          if ( x == a || x == b ) { r = g; return true; }
+          // x & (!x & b) = false
+          if ( x == aiger_not ( a ) || x == aiger_not ( b ) ) { r = aiger_false; return true; }
+        }
+        else
+        {
+          // x & !(!x & b) = x
+          if ( x == aiger_not ( a ) || x == aiger_not ( b ) ) { r = x; return true; }
+        }
+        return false;
+      }
+
+    private:
+      typedef std::tr1::unordered_map< boost::uint64_t, result_type > UniqueTable;
+
+      // the and gate of each operand pair
+      UniqueTable _unique;
+      // the operands of the and gate of each variable, (false, false)
+      // for inputs
+      std::vector< std::pair< result_type, result_type > > _fanins;
   }; 
 
 
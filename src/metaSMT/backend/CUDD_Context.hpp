@@ -1,7 +1,9 @@
 #pragma once
 
 #include "../result_wrapper.hpp"
+#include "../Features.hpp"
 #include "../tags/Logic.hpp"
+#include "../support/GateCache.hpp"
 
 #include <cuddObj.hh>
 
@@ -187,6 +189,23 @@ namespace metaSMT {
     };
 	
   } // namespace solver
+
+  namespace features {
+    /* copies of a Cudd object share the manager and its BDDs */
+    template<>
+    struct copyable_results< solver::CUDD_Context > : boost::mpl::true_ {};
+  }
+
+  /**
+   * BDDs are hashed by their (canonical) node.
+   **/
+  template <>
+  struct gate_hash<BDD> {
+    std::size_t operator() (BDD const & b) const {
+      return boost::hash<DdNode*>()( b.getNode() );
+    }
+  };
+
 } // namespace metaSMT
 
 //  vim: ft=cpp:ts=2:sw=2:expandtab
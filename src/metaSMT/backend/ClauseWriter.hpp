@@ -2,6 +2,7 @@
 
 #include "../tags/SAT.hpp"
 #include "../result_wrapper.hpp"
+#include "../support/ClauseArena.hpp"
 #include "SAT/model_parser.hpp"
 #include "../support/GoTmp.hpp"
 
@@ -18,7 +19,6 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/assign/std/vector.hpp>
-#include <boost/lambda/lambda.hpp>
 #include <boost/spirit/home/support/iterators/istream_iterator.hpp>
  
 namespace metaSMT {
@@ -202,11 +202,11 @@ namespace metaSMT {
       class ClauseWriter
       {
         public:
-          typedef std::vector < int > clause_vec;
-          typedef std::vector < clause_vec > clause_db; 
+          // all clauses, each terminated by 0 like in the DIMACS file
+          typedef std::vector < int > clause_db; 
 
         public:
-          ClauseWriter () : vars (0)
+          ClauseWriter () : vars (0), clauses (0)
         {
         }
 
@@ -222,29 +222,37 @@ namespace metaSMT {
 
           void clause ( std::vector < SAT::tag::lit_tag > const& fromClause )
           {
-            clause_vec cls;
             BOOST_FOREACH ( SAT::tag::lit_tag const& lit, fromClause )
-              cls += toLit ( lit );
-            db += cls;
+              db.push_back ( toLit ( lit ) );
+            db.push_back ( 0 );
+            ++clauses;
+          }
+
+          void add_clauses ( SAT::clause_span const& fromClauses )
+          {
+            for ( SAT::tag::lit_tag const* it = fromClauses.first; it != fromClauses.last; ++it )
+            {
+              db.push_back ( toLit ( *it ) );
+              if ( it->id == 0 )
+                ++clauses;
+            }
           }
 
           void assertion ( SAT::tag::lit_tag lit )
           {
-            clause_vec cls;
-            cls += toLit ( lit ); 
-            db.push_back ( cls ); 
+            db.push_back ( toLit ( lit ) ); 
+            db.push_back ( 0 ); 
+            ++clauses;
           }
 
           void assumption ( SAT::tag::lit_tag lit )
           {
-            clause_vec cls;
-            cls += toLit ( lit ); 
-            assumptions.push_back ( cls ); 
+            assumptions.push_back ( toLit ( lit ) ); 
           }
 
           void write_header ( std::ostream& stream )
           {
-            stream << "p cnf " << vars << " " << db.size() + assumptions.size() << std::endl;
+            stream << "p cnf " << vars << " " << clauses + assumptions.size() << std::endl;
           }
 
           void write_cnf ( std::string const& filename )
@@ -252,18 +260,17 @@ namespace metaSMT {
             std::ofstream cnf ( filename.c_str() ) ;
             write_header ( cnf ); 
 
-            BOOST_FOREACH ( clause_vec const& cls, db )
+            BOOST_FOREACH ( int lit, db )
             {
-              std::for_each (cls.begin(), cls.end(),
-                  cnf << boost::lambda::free1 << " "); 
-              cnf << "0" << std::endl;
+              if ( lit == 0 )
+                cnf << "0\n";
+              else
+                cnf << lit << " ";
             }
 
-            BOOST_FOREACH ( clause_vec const& cls, assumptions )
+            BOOST_FOREACH ( int lit, assumptions )
             {
-              std::for_each (cls.begin(), cls.end(),
-                  cnf << boost::lambda::free1 << " "); 
-              cnf << "0" << std::endl;
+              cnf << lit << " 0\n";
             }
           }
 
@@ -313,8 +320,9 @@ namespace metaSMT {
 
         private:
           clause_db     db; 
-          clause_db     assumptions;
+          std::vector < int > assumptions;
           unsigned      vars;
+          unsigned      clauses;
           std::vector < unsigned > model; 
       };
   } /* solver */
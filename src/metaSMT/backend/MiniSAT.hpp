@@ -3,6 +3,7 @@
 #include "../tags/SAT.hpp"
 #include "../result_wrapper.hpp"
 #include "../Features.hpp" 
+#include "../support/ClauseArena.hpp"
 
  
 #include <vector>
@@ -79,6 +80,19 @@ namespace metaSMT {
           }
         }
 
+        void add_clauses ( SAT::clause_span const& clauses )
+        {
+          for ( SAT::tag::lit_tag const* it = clauses.first; it != clauses.last; ++it )
+          {
+            if ( it->id != 0 )
+            {
+              clause_.push ( toLit ( *it ) );
+              continue;
+            }
+            solver_.addClause ( clause_ );
+            clause_.clear ();
+          }
+        }
 
         void assertion ( SAT::tag::lit_tag lit )
         {
@@ -114,7 +128,12 @@ namespace metaSMT {
         {
           using namespace Minisat;
            
-          lbool val = solver_.modelValue (toLit(lit));
+          Lit l = toLit(lit);
+          // variables created after the last solve are not in the model
+          if ( var(l) >= solver_.model.size() )
+            return result_wrapper ('X');
+
+          lbool val = solver_.modelValue (l);
            
           if ( val == l_True )
             return result_wrapper ( '1' );
@@ -128,6 +147,8 @@ namespace metaSMT {
       private:
         Minisat::Solver solver_;
         Minisat::vec<Minisat::Lit> assumption_;
+        // reused for the clauses of add_clauses
+        Minisat::vec<Minisat::Lit> clause_;
     };
   } /* solver */
 
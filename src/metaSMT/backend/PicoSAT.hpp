@@ -3,6 +3,7 @@
 #include "../tags/SAT.hpp"
 #include "../result_wrapper.hpp"
 #include "../Features.hpp"
+#include "../support/ClauseArena.hpp"
 
 extern "C"
 {
@@ -25,6 +26,7 @@ namespace metaSMT {
   namespace features
   {
     struct addclause_api;
+    struct single_instance;
   }
 
   namespace solver {
@@ -59,6 +61,13 @@ namespace metaSMT {
           picosat_add ( 0 ); 
         }
 
+        void add_clauses ( SAT::clause_span const& clauses )
+        {
+          // picosat terminates its clauses with 0 as well
+          for ( SAT::tag::lit_tag const* it = clauses.first; it != clauses.last; ++it )
+            picosat_add ( toLit ( *it ) );
+        }
+
         void command ( addclause_cmd const&, std::vector < SAT::tag::lit_tag > const& cls )
         {
           clause ( cls );
@@ -119,6 +128,11 @@ namespace metaSMT {
     template<>
       struct supports< solver::PicoSAT, features::addclause_api>
       : boost::mpl::true_ {};
+
+    /* picosat_init sets up global state */
+    template<>
+      struct supports< solver::PicoSAT, features::single_instance>
+      : boost::mpl::true_ {};
   } /* features */
 
 } /* metaSMT */
@@ -2,12 +2,21 @@
 #pragma once
 
 #include "Aiger.hpp"
+#include "AigCnf.hpp"
+#include "AigOptimizer.hpp"
+#include "AigSimulator.hpp"
 #include "../tags/SAT.hpp"
+#include "../result_wrapper.hpp"
+#include "../support/ClauseArena.hpp"
 #include "../Features.hpp"
+#include "../API/Options.hpp"
+#include "../support/Options.hpp"
 
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/logic/tribool.hpp>
+#include <boost/tr1/unordered_map.hpp>
 #include <vector>
-#include <set>
 
 namespace metaSMT
 {
@@ -18,6 +27,20 @@ namespace metaSMT
     struct addclause_api;
   }
 
+  /**
+   * And-inverter graph of the expressions, encoded into clauses in solve.
+   * Only the and gates in the cone of influence of the assertions and
+   * assumptions are encoded. The translation is incremental: solve only
+   * looks at the gates created and the assertions made since the last
+   * solve, encoded gates are remembered in a bitmap over the variables.
+   *
+   * The option aig_optimize selects passes of the AigOptimizer (balance,
+   * rewrite, fraig) that run on the new cones before they are encoded.
+   * With aig_simulate, solve first looks for a satisfying assignment
+   * among random simulation patterns and only calls the SAT solver if
+   * none is found. With aig_cnf set to cuts the cones are encoded by
+   * the AigCnf mapper instead of three clauses per and gate.
+   **/
   template<typename SatSolver>
   class SAT_Aiger
   {
@@ -26,6 +49,15 @@ namespace metaSMT
        
     public:
       SAT_Aiger ()
+        : optimizer ( aiger )
+        , simulator ( aiger )
+        , rounds ( 0 )
+        , cut_cnf ( false )
+        , model ( -1 )
+        , simulated ( 0 )
+        , direct ( false )
+        , asserted ( 0 )
+        , indexed ( 0 )
       {
         true_var = aiger_lit2var ( aiger.new_var () );
 
@@ -36,9 +68,31 @@ namespace metaSMT
       template< typename Command, typename Expr >
       void command ( Command& cmd, Expr& e )
       {
+        // e.g. clauses the simulation does not know about
+        direct = true;
         solver.command ( cmd, e );
       }
 
+      void command ( setup_option_map_cmd const &, Options const & opt )
+      {
+        _opt = opt;
+        configure ();
+      }
+
+      void command ( set_option_cmd const &, Options const & opt
+          , std::string const & key, std::string const & value )
+      {
+        _opt = opt;
+        configure ();
+      }
+
+      AigStatistics command ( aig_statistics_cmd const & )
+      {
+        AigStatistics stats = optimizer.statistics ();
+        stats.simulated = simulated;
+        return stats;
+      }
+
       template<typename Tag, typename Any>
       result_type operator() (Tag const& tag, Any arg )
       {
@@ -100,54 +154,112 @@ namespace metaSMT
       void _eval ( aiger_and const& and_sym ) 
       {
         unsigned lhs  = and_sym.lhs;
-        unsigned rhs0 = and_sym.rhs0;
-        unsigned rhs1 = and_sym.rhs1;
+        unsigned rhs0 = optimizer.resolve ( and_sym.rhs0 );
+        unsigned rhs1 = optimizer.resolve ( and_sym.rhs1 );
 
-        if ( evaluated.find ( lhs ) == evaluated.end() )
+        if ( !is_encoded ( lhs ) )
         {
 //           std::cout << "And: " << lhs << " " << rhs0 << " " << rhs1 << std::endl;
 //           std::cout << "Sign: " << negated (lhs )<< " " << negated (rhs0) << " " << negated (rhs1) << std::endl;
-         std::vector < SAT::tag::lit_tag > clause ( 2 );
-
-         int lhsVar  = sat_lit ( lhs );
-         int rhs0Var = sat_lit ( rhs0 );
-         int rhs1Var = sat_lit ( rhs1 );
+         SAT::tag::lit_tag lhsLit  = { sat_lit ( lhs ) };
+         SAT::tag::lit_tag rhs0Lit = { sat_lit ( rhs0 ) };
+         SAT::tag::lit_tag rhs1Lit = { sat_lit ( rhs1 ) };
 
-         clause[0].id = -lhsVar;
-         clause[1].id =  rhs0Var;
-         solver.clause ( clause );
+         clauses.push ( -lhsLit, rhs0Lit );
+         clauses.push ( -lhsLit, rhs1Lit );
+         clauses.push ( lhsLit, -rhs0Lit, -rhs1Lit );
 
-         clause[1].id = rhs1Var;
-         solver.clause ( clause );
-
-         clause.resize ( 3 );
-         clause[0].id = lhsVar; 
-         clause[1].id = -rhs0Var;
-         clause[2].id = -rhs1Var; 
-         solver.clause ( clause );
+          set_encoded ( aiger_lit2var ( lhs ) );
+        }
+      }
 
+      /**
+       * records the and gates created since the last call by their output
+       **/
+      void index_ands ()
+      {
+        and_index.resize ( aiger.aig->maxvar + 1, 0 );
+        for ( ; indexed < aiger.aig->num_ands; ++indexed )
+        {
+          and_index[ aiger_lit2var ( aiger.aig->ands[indexed].lhs ) ] = indexed + 1;
+        }
+      }
 
-          evaluated.insert ( lhs );
+      /**
+       * encodes the and gates in the cone of influence of lit. Gates that
+       * are not reachable from an assertion or assumption get no clauses.
+       **/
+      void require ( result_type lit )
+      {
+        std::vector < result_type > pending ( 1, aiger_strip ( lit ) );
+        while ( !pending.empty() )
+        {
+          result_type l = pending.back();
+          pending.pop_back();
+          aiger_and const* and_sym = and_gate ( l );
+          if ( !and_sym || is_encoded ( l ) )
+            continue;
+
+          _eval ( *and_sym );
+          pending.push_back ( aiger_strip ( optimizer.resolve ( and_sym->rhs0 ) ) );
+          pending.push_back ( aiger_strip ( optimizer.resolve ( and_sym->rhs1 ) ) );
         }
       }
 
       bool solve () 
       {
-        for (unsigned i = 0; i < aiger.aig->num_ands; i++)
+        values.clear ();
+        model = -1;
+        if ( rounds > 0 && !direct && simulate () )
+        {
+          assumptions.clear();
+          return true;
+        }
+
+        if ( optimizer.enabled () )
+        {
+          std::vector < result_type > roots ( assertions.begin() + asserted, assertions.end() );
+          roots.insert ( roots.end(), assumptions.begin(), assumptions.end() );
+          optimizer.optimize ( roots, encoded );
+        }
+        index_ands ();
+
+        // the cones of the earlier assertions are already encoded
+        std::vector < result_type > roots;
+        for ( unsigned i = asserted; i < assertions.size(); ++i )
+          roots.push_back ( optimizer.resolve ( assertions[i] ) );
+        BOOST_FOREACH ( result_type assumption, assumptions )
+          roots.push_back ( optimizer.resolve ( assumption ) );
+
+        if ( cut_cnf )
+        {
+          std::vector < unsigned > mapped;
+          mapper.encode ( roots, network ( *this ), clauses, mapped );
+          BOOST_FOREACH ( unsigned var, mapped )
+            set_encoded ( var );
+        }
+        else
+        {
+          BOOST_FOREACH ( result_type root, roots )
+            require ( root );
+        }
+
+        if ( !clauses.empty() )
         {
-          _eval ( aiger.aig->ands[i] );
+          solver.add_clauses ( clauses.span() );
+          clauses.clear();
         }
 
         SAT::tag::lit_tag tmp;
-        BOOST_FOREACH ( unsigned assertion, assertions )
+        for ( ; asserted < assertions.size(); ++asserted )
         {
-          tmp.id = sat_lit ( assertion ) ; 
+          tmp.id = sat_lit ( optimizer.resolve ( assertions[asserted] ) ) ; 
           solver.assertion ( tmp ); 
         }
 
         BOOST_FOREACH ( unsigned assumption, assumptions )
         {
-          tmp.id = sat_lit ( assumption ) ; 
+          tmp.id = sat_lit ( optimizer.resolve ( assumption ) ) ; 
           solver.assumption ( tmp  ); 
         }
 
@@ -157,17 +269,209 @@ namespace metaSMT
 
       result_wrapper read_value ( result_type var ) 
       {
-        SAT::tag::lit_tag lit = {  sat_lit ( var ) };
-        return solver.read_value ( lit ); 
+        index_ands ();
+        return result_wrapper ( value ( optimizer.resolve ( var ) ) );
+      }
+
+    private:
+      /**
+       * searches a pattern of the simulator that satisfies all
+       * assertions and assumptions. The pattern becomes the model,
+       * nothing is encoded.
+       **/
+      bool simulate ()
+      {
+        // assertions[0] is true_var, which only exists in the SAT solver
+        std::vector < result_type > roots ( assertions.begin() + 1, assertions.end() );
+        roots.insert ( roots.end(), assumptions.begin(), assumptions.end() );
+
+        for ( unsigned round = 0; round < rounds; ++round )
+        {
+          if ( round > 0 )
+            simulator.randomize ();
+          simulator.update ();
+          model = simulator.satisfying ( roots.begin(), roots.end() );
+          if ( model >= 0 )
+          {
+            ++simulated;
+            return true;
+          }
+        }
+        return false;
+      }
+
+      /**
+       * reads the SAT_Aiger options:
+       *   aig_optimize: comma separated passes out of balance, rewrite
+       *     and fraig, none by default
+       *   aig_fraig_conflicts: conflicts allowed for each equivalence
+       *     check of fraig, default 100
+       *   aig_simulate: rounds of AigSimulator::PATTERNS random patterns
+       *     tried before the SAT solver, default 0
+       *   aig_cnf: gates (default) for three clauses per and gate or
+       *     cuts for the cut-based CNF of AigCnf
+       *   aig_cnf_cut_size: leaves of the cuts of AigCnf, 2 to 6,
+       *     default 4
+       **/
+      void configure ()
+      {
+        optimizer.configure ( _opt.get ( "aig_optimize", "" )
+            , boost::lexical_cast < unsigned > ( _opt.get ( "aig_fraig_conflicts", "100" ) ) );
+        rounds = boost::lexical_cast < unsigned > ( _opt.get ( "aig_simulate", "0" ) );
+        cut_cnf = _opt.get ( "aig_cnf", "gates" ) == "cuts";
+        mapper.cut_size ( boost::lexical_cast < unsigned > ( _opt.get ( "aig_cnf_cut_size", "4" ) ) );
+      }
+
+      /**
+       * the view of AigCnf on the gates that are not encoded yet
+       **/
+      struct network
+      {
+        explicit network ( SAT_Aiger & self )
+          : self ( self )
+        {}
+
+        bool gate ( unsigned var, result_type & rhs0, result_type & rhs1 ) const
+        {
+          const result_type lit = aiger_var2lit ( var );
+          aiger_and const* and_sym = self.and_gate ( lit );
+          if ( !and_sym || self.is_encoded ( lit ) )
+            return false;
+          rhs0 = self.optimizer.resolve ( and_sym->rhs0 );
+          rhs1 = self.optimizer.resolve ( and_sym->rhs1 );
+          return true;
+        }
+
+        int literal ( result_type lit ) const
+        {
+          return self.sat_lit ( lit );
+        }
+
+        SAT_Aiger & self;
+      };
+
+      void set_encoded ( unsigned var )
+      {
+        if ( encoded.size() <= var )
+          encoded.resize ( var + 1, false );
+        encoded[ var ] = true;
+      }
+
+      bool is_encoded ( result_type lit ) const
+      {
+        const unsigned var = aiger_lit2var ( lit );
+        return var < encoded.size() && encoded[var];
+      }
+
+      /**
+       * the and gate with output lit, 0 for inputs and constants
+       **/
+      aiger_and const* and_gate ( result_type lit ) const
+      {
+        const unsigned var = aiger_lit2var ( lit );
+        if ( var >= and_index.size() || and_index[var] == 0 )
+          return 0;
+        return aiger.aig->ands + and_index[var] - 1;
+      }
+
+      /**
+       * value of lit in the current model. And gates outside of the
+       * encoded cone are evaluated on their inputs, unassigned inputs
+       * read as false. After a solve by simulation the model is the
+       * satisfying pattern.
+       **/
+      boost::logic::tribool value ( result_type lit )
+      {
+        std::vector < result_type > pending ( 1, aiger_strip ( lit ) );
+        while ( !pending.empty() )
+        {
+          result_type l = pending.back();
+          if ( values.count ( l ) )
+          {
+            pending.pop_back();
+            continue;
+          }
+
+          aiger_and const* gate = and_gate ( l );
+          if ( l == aiger_false )
+          {
+            values[l] = false;
+          }
+          else if ( model >= 0 && simulator.simulated ( l ) )
+          {
+            values[l] = simulator.value ( l, model );
+          }
+          else if ( !gate || is_encoded ( l ) )
+          {
+            if ( model >= 0 )
+            {
+              values[l] = boost::logic::indeterminate;
+            }
+            else
+            {
+              SAT::tag::lit_tag sat = { sat_lit ( l ) };
+              values[l] = solver.read_value ( sat );
+            }
+          }
+          else
+          {
+            aiger_and const& and_sym = *gate;
+            result_type rhs0 = aiger_strip ( and_sym.rhs0 );
+            result_type rhs1 = aiger_strip ( and_sym.rhs1 );
+            if ( !values.count ( rhs0 ) || !values.count ( rhs1 ) )
+            {
+              pending.push_back ( rhs0 );
+              pending.push_back ( rhs1 );
+              continue;
+            }
+            values[l] = input ( and_sym.rhs0 ) && input ( and_sym.rhs1 );
+          }
+          pending.pop_back();
+        }
+
+        boost::logic::tribool v = values[ aiger_strip ( lit ) ];
+        return aiger_sign ( lit ) ? !v : v;
+      }
+
+      bool input ( result_type lit )
+      {
+        boost::logic::tribool v = values[ aiger_strip ( lit ) ];
+        const bool b = !boost::logic::indeterminate ( v ) && v;
+        return aiger_sign ( lit ) ? !b : b;
       }
 
     private:
       SatSolver solver;
       Aiger     aiger;
+      AigOptimizer optimizer;
+      AigSimulator simulator;
+      AigCnf    mapper;
+      Options   _opt;
+      // simulation rounds before each solve
+      unsigned  rounds;
+      // encode with the cuts of mapper
+      bool      cut_cnf;
+      // pattern of the simulator that satisfied the last solve, -1 if
+      // the SAT solver found the model
+      int       model;
+      // number of solves answered by the simulator
+      unsigned long simulated;
+      // the SAT solver got constraints directly, e.g. addclause
+      bool      direct;
 
       std::vector < result_type > assertions; 
       std::vector < result_type > assumptions; 
-      std::set < result_type >    evaluated;
+      // assertions[0, asserted) are forwarded to the solver
+      unsigned                    asserted;
+      // the variables whose and gate is encoded
+      std::vector < bool >        encoded;
+      // position + 1 of the and gate of each variable in aiger.aig->ands,
+      // 0 for inputs
+      std::vector < unsigned >    and_index;
+      // aiger.aig->ands[0, indexed) are in and_index
+      unsigned                    indexed;
+      std::tr1::unordered_map < result_type, boost::logic::tribool > values;
+      SAT::ClauseArena            clauses;
 
       result_type true_var; 
 
@@ -179,6 +483,18 @@ namespace metaSMT
     struct supports< SAT_Aiger<Context>, features::addclause_api>
     : boost::mpl::true_ {};
 
+    template<typename Context>
+    struct supports< SAT_Aiger<Context>, setup_option_map_cmd>
+    : boost::mpl::true_ {};
+
+    template<typename Context>
+    struct supports< SAT_Aiger<Context>, set_option_cmd>
+    : boost::mpl::true_ {};
+
+    template<typename Context>
+    struct supports< SAT_Aiger<Context>, aig_statistics_cmd>
+    : boost::mpl::true_ {};
+
     /* Forward all other supported operations */
     template<typename Context, typename Feature>
     struct supports< SAT_Aiger<Context>, Feature>
@@ -3,11 +3,18 @@
 
 #include "../tags/SAT.hpp"
 #include "../Features.hpp"
+#include "../result_wrapper.hpp"
+#include "../API/Options.hpp"
+#include "../support/Options.hpp"
+#include "../impl/_var_id.hpp"
+#include "../support/ClauseArena.hpp"
 
 #include <vector>
 
 #include <boost/foreach.hpp>
 #include <boost/any.hpp>
+#include <boost/logic/tribool.hpp>
+#include <boost/tr1/unordered_map.hpp>
 
 namespace metaSMT
 {
@@ -18,6 +25,28 @@ namespace metaSMT
     struct addclause_api;
   }
    
+  /**
+   * Tseitin encoding of the gates into clauses.
+   *
+   * With the option sat_clause_lazy set to "1" the gates are only
+   * recorded when they are created. Their clauses are emitted when the
+   * gate becomes reachable from an assertion, assumption or added clause
+   * (cone of influence), so intermediate results that are never asserted
+   * cost no clauses. Encoded gates are remembered across solves.
+   *
+   * With the option sat_clause_polarity set to "1" the gates are encoded
+   * polarity aware (Plaisted-Greenbaum): a gate only gets the clauses of
+   * the direction in which it is used by the assertions, assumptions and
+   * added clauses, out -> f(inputs) if it is used positively and
+   * f(inputs) -> out if it is used negatively. A direction needed later
+   * is added on demand, so incremental use stays sound.
+   *
+   * In both modes the values of gates without their full definition are
+   * computed from their inputs in read_value.
+   *
+   * The clauses are collected in a ClauseArena and handed to the SAT
+   * solver with add_clauses before every assertion, assumption and solve.
+   **/
   template<typename SatSolver>
   class SAT_Clause
   {
@@ -26,8 +55,10 @@ namespace metaSMT
        
     public:
       SAT_Clause ()
+        : _polarity(false)
+        , _lazy(false)
       {
-        true_lit.id = impl::new_var_id();
+        true_lit.id = static_cast<int>( _new_var() );
         //std::cout << "<true>\n";
         solver.assertion ( true_lit );
         //std::cout << "</true>\n";
@@ -41,7 +72,7 @@ namespace metaSMT
 
       result_type operator() (logic::tag::var_tag const& tag, boost::any arg )
       {
-        result_type lit = { impl::new_var_id() };
+        result_type lit = { static_cast<int>( _new_var() ) };
         return lit; 
       }
 
@@ -59,29 +90,17 @@ namespace metaSMT
            
       result_type operator() (logic::tag::and_tag const& tag, result_type lhs, result_type rhs )
       {
-        result_type out = { impl:: new_var_id() };
-        clause3(-lhs,-rhs, out);
-        clause2( rhs,-out);
-        clause2( lhs,-out);
-        return out;
+        return gate(AND, lhs, rhs);
       }
 
       result_type operator() (logic::tag::or_tag const& tag, result_type lhs, result_type rhs )
       {
-        result_type out = { impl:: new_var_id() };
-        clause3( lhs, rhs,-out);
-        clause2(-rhs, out);
-        clause2(-lhs, out);
-        return out;
+        return gate(OR, lhs, rhs);
       }
 
       result_type operator() (logic::tag::nor_tag const& tag, result_type lhs, result_type rhs )
       {
-        result_type out = { impl:: new_var_id() };
-        clause3( lhs, rhs, out);
-        clause2(-rhs,-out);
-        clause2(-lhs,-out);
-        return out;
+        return -gate(OR, lhs, rhs);
       }
 
       result_type operator() (logic::tag::implies_tag const& tag, result_type lhs, result_type rhs )
@@ -91,31 +110,17 @@ namespace metaSMT
 
       result_type operator() (logic::tag::nand_tag const& tag, result_type lhs, result_type rhs )
       {
-        result_type out = { impl:: new_var_id() };
-        clause3(-lhs,-rhs,-out);
-        clause2( rhs, out);
-        clause2( lhs, out);
-        return out;
+        return -gate(AND, lhs, rhs);
       }
 
       result_type operator() (logic::tag::xnor_tag const& tag, result_type lhs, result_type rhs )
       {
-        result_type out = { impl:: new_var_id() };
-        clause3( lhs, rhs, out);
-        clause3( lhs,-rhs,-out);
-        clause3(-lhs, rhs,-out);
-        clause3(-lhs,-rhs, out);
-        return out;
+        return -gate(XOR, lhs, rhs);
       }
 
       result_type operator() (logic::tag::xor_tag const& tag, result_type lhs, result_type rhs )
       {
-        result_type out = { impl:: new_var_id() };
-        clause3( lhs, rhs,-out);
-        clause3( lhs,-rhs, out);
-        clause3(-lhs, rhs, out);
-        clause3(-lhs,-rhs,-out);
-        return out;
+        return gate(XOR, lhs, rhs);
       }
 
 
@@ -149,12 +154,7 @@ namespace metaSMT
 
       result_type operator() (logic::tag::ite_tag const& tag, result_type op1, result_type op2, result_type op3  )
       {
-        result_type out = { impl:: new_var_id() };
-        clause3( op1, op3, -out);
-        clause3( op1,-op3,  out);
-        clause3(-op1, op2, -out);
-        clause3(-op1,-op2,  out);
-        return out;
+        return gate(ITE, op1, op2, op3);
       }
 
       template<typename T>
@@ -166,12 +166,16 @@ namespace metaSMT
       void assertion ( result_type lit )
       {
         //std::cout << "assert " << lit << std::endl;
+        require( lit );
+        flush();
         solver.assertion( lit );
       }
 
       void assumption ( result_type lit )
       {
         //std::cout << "assume " << lit << std::endl;
+        require( lit );
+        flush();
         solver.assumption( lit );
       }
 
@@ -181,34 +185,250 @@ namespace metaSMT
         solver.command ( cmd, expr ); 
       }
 
+      void command ( addclause_cmd const& cmd, std::vector < result_type > const& cls )
+      {
+        BOOST_FOREACH ( result_type const& lit, cls )
+          require( lit );
+        flush();
+        solver.command ( cmd, cls );
+      }
+
+      void command ( setup_option_map_cmd const &, Options const & opt )
+      {
+        _opt = opt;
+        configure();
+      }
+
+      void command ( set_option_cmd const &, Options const & opt
+          , std::string const & key, std::string const & value )
+      {
+        _opt = opt;
+        configure();
+      }
+
       bool solve () 
       {
+        _values.clear();
+        flush();
         return solver.solve (); 
       }
 
       result_wrapper read_value ( result_type lit ) 
       {
-        return solver.read_value ( lit ); 
+        if ( _gates.empty() ) {
+          return solver.read_value ( lit ); 
+        }
+        return result_wrapper( value( lit ) );
       }
 
       void clause2(result_type a, result_type b){
-        std::vector<result_type> cls(2);
-        cls[0]=a;
-        cls[1]=b;
-        solver.clause(cls);
+        _clauses.push(a, b);
+        if ( _clauses.literals() >= FLUSH_LITERALS ) flush();
       }
 
       void clause3(result_type a, result_type b, result_type c){
-        std::vector<result_type> cls(3);
-        cls[0]=a;
-        cls[1]=b;
-        cls[2]=c;
-        solver.clause(cls);
+        _clauses.push(a, b, c);
+        if ( _clauses.literals() >= FLUSH_LITERALS ) flush();
+      }
+
+      /**
+       * hands the buffered clauses to the SAT solver in one batch
+       **/
+      void flush () {
+        if ( _clauses.empty() ) return;
+        solver.add_clauses( _clauses.span() );
+        _clauses.clear();
+      }
+
+    private:
+      enum GateKind { AND, OR, XOR, ITE };
+
+      // bound on the literals buffered before they are handed to the solver
+      enum { FLUSH_LITERALS = 1 << 16 };
+
+      // the directions of a gate definition
+      enum { POSITIVE = 1, NEGATIVE = 2 };
+
+      struct Gate {
+        GateKind kind;
+        result_type in[3];
+        // directions that are already encoded
+        unsigned char encoded;
+      };
+
+      typedef std::tr1::unordered_map< int, Gate > GateMap;
+
+      result_type gate ( GateKind kind, result_type a, result_type b, result_type c = result_type() )
+      {
+        result_type out = { static_cast<int>( _new_var() ) };
+        Gate g;
+        g.kind = kind;
+        g.in[0] = a;
+        g.in[1] = b;
+        g.in[2] = c;
+        g.encoded = 0;
+        if ( _polarity || _lazy ) {
+          _gates.insert( std::make_pair(out.var(), g) );
+        } else {
+          encode( out, g, POSITIVE | NEGATIVE );
+          // inputs deferred before the options were turned off
+          const unsigned n = kind == ITE ? 3 : 2;
+          for ( unsigned i = 0; i < n; ++i ) {
+            require( g.in[i] );
+          }
+        }
+        return out;
+      }
+
+      /**
+       * encodes the gate definitions needed for lit to hold: the gate of
+       * lit and recursively the gates of its inputs. In polarity mode
+       * only the directions in which the gates are used are encoded,
+       * otherwise (also once the mode is turned off) the full definitions.
+       **/
+      void require ( result_type lit )
+      {
+        if ( _gates.empty() ) return;
+        std::vector< result_type > pending(1, lit);
+        while ( !pending.empty() ) {
+          result_type l = pending.back();
+          pending.pop_back();
+          typename GateMap::iterator it = _gates.find( l.var() );
+          if ( it == _gates.end() ) continue;
+
+          Gate & g = it->second;
+          const unsigned char dir = !_polarity ? POSITIVE | NEGATIVE
+            : l.id > 0 ? POSITIVE : NEGATIVE;
+          if ( (g.encoded & dir) == dir ) continue;
+          result_type out = { it->first };
+          encode( out, g, dir & ~g.encoded );
+
+          const unsigned n = g.kind == ITE ? 3 : 2;
+          for ( unsigned i = 0; i < n; ++i ) {
+            // xor inputs and the ite selector occur in both polarities,
+            // the other inputs in the polarity of the direction
+            if ( g.kind == XOR || (g.kind == ITE && i == 0) ) {
+              pending.push_back( g.in[i] );
+              pending.push_back( -g.in[i] );
+            } else {
+              pending.push_back( dir == POSITIVE ? g.in[i] : -g.in[i] );
+            }
+          }
+        }
+      }
+
+      void encode ( result_type out, Gate & g, unsigned char dir )
+      {
+        result_type a = g.in[0];
+        result_type b = g.in[1];
+        result_type c = g.in[2];
+        if ( dir & POSITIVE ) {
+          switch ( g.kind ) {
+            case AND: clause2( a,-out); clause2( b,-out); break;
+            case OR:  clause3( a, b,-out); break;
+            case XOR: clause3( a, b,-out); clause3(-a,-b,-out); break;
+            case ITE: clause3( a, c,-out); clause3(-a, b,-out); break;
+          }
+        }
+        if ( dir & NEGATIVE ) {
+          switch ( g.kind ) {
+            case AND: clause3(-a,-b, out); break;
+            case OR:  clause2(-a, out); clause2(-b, out); break;
+            case XOR: clause3( a,-b, out); clause3(-a, b, out); break;
+            case ITE: clause3( a,-c, out); clause3(-a,-b, out); break;
+          }
+        }
+        g.encoded |= dir;
+      }
+
+      /**
+       * value of lit in the current model with the gates evaluated on
+       * their inputs
+       **/
+      boost::logic::tribool value ( result_type lit )
+      {
+        std::vector< int > pending(1, lit.var());
+        while ( !pending.empty() ) {
+          const int v = pending.back();
+          if ( _values.count(v) ) {
+            pending.pop_back();
+            continue;
+          }
+          typename GateMap::const_iterator it = _gates.find( v );
+          if ( it == _gates.end() ) {
+            result_type var = { v };
+            _values[v] = solver.read_value( var );
+            pending.pop_back();
+            continue;
+          }
+
+          Gate const & g = it->second;
+          const unsigned n = g.kind == ITE ? 3 : 2;
+          bool ready = true;
+          for ( unsigned i = 0; i < n; ++i ) {
+            if ( !_values.count( g.in[i].var() ) ) {
+              pending.push_back( g.in[i].var() );
+              ready = false;
+            }
+          }
+          if ( !ready ) continue;
+
+          const bool a = input( g.in[0] );
+          const bool b = input( g.in[1] );
+          bool r = false;
+          switch ( g.kind ) {
+            case AND: r = a && b; break;
+            case OR:  r = a || b; break;
+            case XOR: r = a != b; break;
+            case ITE: r = a ? b : input( g.in[2] ); break;
+          }
+          _values[v] = r;
+          pending.pop_back();
+        }
+        return literal( lit );
+      }
+
+      boost::logic::tribool literal ( result_type lit ) const
+      {
+        boost::logic::tribool v = _values.find( lit.var() )->second;
+        return lit.id < 0 ? !v : v;
+      }
+
+      /**
+       * value of a gate input, unassigned variables are not constrained
+       * by the encoded clauses and read as false, like in the integer
+       * conversion of result_wrapper.
+       **/
+      bool input ( result_type lit ) const
+      {
+        boost::logic::tribool v = _values.find( lit.var() )->second;
+        const bool b = !boost::logic::indeterminate(v) && v;
+        return lit.id < 0 ? !b : b;
+      }
+
+      /**
+       * reads the SAT_Clause options:
+       *   sat_clause_polarity: "1" encodes the gates polarity aware
+       *   sat_clause_lazy: "1" encodes only the cone of influence of the
+       *     assertions, assumptions and added clauses
+       **/
+      void configure ()
+      {
+        _polarity = _opt.get("sat_clause_polarity", "0") == "1";
+        _lazy = _opt.get("sat_clause_lazy", "0") == "1";
       }
 
     private:
       SatSolver solver;
+      SAT::ClauseArena _clauses;
+      // dense variables of this solver, independent of other contexts
+      impl::var_allocator _new_var;
       result_type true_lit; 
+      Options _opt;
+      bool _polarity;
+      bool _lazy;
+      GateMap _gates;
+      std::tr1::unordered_map< int, boost::logic::tribool > _values;
   }; 
 
   namespace features {
@@ -217,6 +437,14 @@ namespace metaSMT
       struct supports< SAT_Clause<Context>, features::addclause_api>
       : boost::mpl::true_ {};
 
+    template<typename Context>
+      struct supports< SAT_Clause<Context>, setup_option_map_cmd>
+      : boost::mpl::true_ {};
+
+    template<typename Context>
+      struct supports< SAT_Clause<Context>, set_option_cmd>
+      : boost::mpl::true_ {};
+
     /* Forward all other supported operations */
     template<typename Context, typename Feature>
       struct supports< SAT_Clause<Context>, Feature>
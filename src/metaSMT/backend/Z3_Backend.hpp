@@ -8,6 +8,7 @@
 #include <z3++.h>
 
 #include <boost/any.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/mpl/map/map40.hpp>
 #include <boost/spirit/include/qi.hpp>
 #include <boost/tuple/tuple.hpp>
@@ -129,10 +130,30 @@ namespace metaSMT {
       // typedef z3::ast result_type;
 
       Z3_Backend()
-        : solver_(ctx_)
+        : context_(new z3::context())
+        , ctx_(*context_)
+        , solver_(ctx_)
         , assumption_( (*this)(predtags::true_tag(), boost::any()) )
       {}
 
+      /**
+       * the copy shares the context of other, so results of other stay
+       * valid in the copy, and starts with the assertions of other in a
+       * new solver (without the scopes of the stack api). Copies must not
+       * be used concurrently.
+       **/
+      Z3_Backend( Z3_Backend const & other )
+        : context_(other.context_)
+        , ctx_(*context_)
+        , solver_(ctx_)
+        , assumption_(other.assumption_)
+      {
+        z3::expr_vector assertions = other.solver_.assertions();
+        for ( unsigned i = 0; i < assertions.size(); ++i ) {
+          solver_.add( assertions[i] );
+        }
+      }
+
       ~Z3_Backend()
       {}
 
@@ -195,11 +216,10 @@ namespace metaSMT {
       }
 
       bool solve() {
-        solver_.push();
-        assertion(assumption_);
-        z3::check_result result = solver_.check(ctx_);
+        // checked as assumption, a pushed scope would drop its model
+        z3::expr assumption = assumption_;
+        z3::check_result result = solver_.check(1, &assumption);
         // std::cerr << result << '\n';
-        solver_.pop();
         assumption_ = (*this)(predtags::true_tag(), boost::any());
         return (result == z3::sat);
       }
@@ -650,7 +670,8 @@ namespace metaSMT {
       }
 
     private:
-      z3::context ctx_;
+      boost::shared_ptr<z3::context> context_;
+      z3::context & ctx_;
       z3::solver solver_;
       result_type assumption_;
     }; // Z3_Backend
@@ -660,5 +681,9 @@ namespace metaSMT {
     template<>
     struct supports< solver::Z3_Backend, features::stack_api >
     : boost::mpl::true_ {};
+
+    /* copies share the context and its expressions */
+    template<>
+    struct copyable_results< solver::Z3_Backend > : boost::mpl::true_ {};
   } // features
 } // metaSMT
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../support/disable_warnings.hpp"
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "../support/enable_warnings.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace metaSMT {
+  namespace concurrent {
+
+    /**
+     * @brief runs independent tasks on a pool of threads.
+     *
+     * Returns whether all tasks returned true. Once a task returned
+     * false the tasks that did not start yet are skipped, running tasks
+     * finish. Meant as scheduler of GraphSolver_Context:
+     *
+     * \code
+     *  GraphSolver_Context< BitBlast< SAT_Clause< MiniSAT > > > ctx;
+     *  set_option(ctx, "graph_components", "1");
+     *  ctx.set_scheduler( concurrent::ParallelScheduler() );
+     * \endcode
+     **/
+    struct ParallelScheduler {
+      typedef boost::function0<bool> task_type;
+
+      explicit ParallelScheduler( unsigned threads = boost::thread::hardware_concurrency() )
+        : threads( threads > 0 ? threads : 1 )
+      {}
+
+      bool operator() ( std::vector<task_type> const & tasks ) const {
+        State state( tasks );
+        boost::thread_group group;
+        const unsigned n = std::min<std::size_t>( threads, tasks.size() );
+        for ( unsigned i = 0; i < n; ++i ) {
+          group.create_thread( boost::bind( &State::work, &state ) );
+        }
+        group.join_all();
+
+        if ( state.failed ) {
+          throw std::runtime_error( "ParallelScheduler: " + state.error );
+        }
+        return state.result;
+      }
+
+      unsigned threads;
+
+      private:
+        struct State {
+          State( std::vector<task_type> const & tasks )
+            : tasks(tasks), next(0), result(true), failed(false)
+          {}
+
+          void work() {
+            while ( true ) {
+              std::size_t i;
+              {
+                boost::mutex::scoped_lock lock( mutex );
+                if ( !result || failed || next == tasks.size() ) {
+                  return;
+                }
+                i = next++;
+              }
+
+              bool r = false;
+              std::string what;
+              bool ok = true;
+              try {
+                r = tasks[i]();
+              } catch ( std::exception const & e ) {
+                ok = false;
+                what = e.what();
+              } catch ( ... ) {
+                ok = false;
+                what = "unknown exception";
+              }
+
+              boost::mutex::scoped_lock lock( mutex );
+              if ( !ok ) {
+                failed = true;
+                error = what;
+              } else if ( !r ) {
+                result = false;
+              }
+            }
+          }
+
+          std::vector<task_type> const & tasks;
+          boost::mutex mutex;
+          std::size_t next;
+          bool result;
+          bool failed;
+          std::string error;
+        };
+    };
+
+  } /* namespace concurrent */
+} /* namespace metaSMT */
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
@@ -2,6 +2,29 @@
 
 namespace metaSMT {
   namespace impl {
+      /**
+       * process-wide unique ids of the frontend variables, thread safe
+       **/
       unsigned new_var_id();
+
+      /**
+       * dense variable ids 1, 2, ... of a single solver context
+       **/
+      class var_allocator {
+        public:
+          var_allocator() : _last(0) {}
+
+          unsigned operator() () {
+            return ++_last;
+          }
+
+          // number of allocated variables
+          unsigned size() const {
+            return _last;
+          }
+
+        private:
+          unsigned _last;
+      };
   } /* impl */
 } /* metaSMT */
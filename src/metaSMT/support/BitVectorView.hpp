@@ -0,0 +1,169 @@
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace metaSMT {
+
+  /**
+   * @brief shared, immutable bit-vector with O(1) slices and concatenation
+   *
+   * A view references a range of a reference counted node. Copying a view,
+   * taking a slice or concatenating two views never copies bits: slices
+   * share the node, a concatenation allocates a node that refers to both
+   * parts and is flattened on the first access to its bits.
+   *
+   * Views are copy-on-write: the non-const accessors copy the bits first
+   * if the node is shared, so a freshly constructed view can be filled in
+   * place. Bit 0 is the least significant bit.
+   **/
+  template <typename Bit>
+  class BitVectorView {
+    private:
+      struct Node;
+
+    public:
+      typedef Bit value_type;
+      typedef Bit const * const_iterator;
+      typedef Bit * iterator;
+      typedef std::size_t size_type;
+
+      BitVectorView()
+        : _offset(0), _width(0)
+      {}
+
+      explicit BitVectorView( size_type width, Bit const & fill = Bit() )
+        : _node( new Node(width, fill) ), _offset(0), _width(width)
+      {}
+
+      size_type size() const { return _width; }
+      bool empty() const { return _width == 0; }
+
+      const_iterator begin() const { return data() + _offset; }
+      const_iterator end() const { return begin() + _width; }
+
+      iterator begin() { return mutable_data() + _offset; }
+      iterator end() { return begin() + _width; }
+
+      Bit const & operator[] ( size_type i ) const {
+        assert( i < _width );
+        return begin()[i];
+      }
+
+      Bit & operator[] ( size_type i ) {
+        assert( i < _width );
+        return begin()[i];
+      }
+
+      Bit const & front() const { return (*this)[0]; }
+      Bit const & back() const { return (*this)[_width-1]; }
+
+      /**
+       * the bits [offset, offset+width) of this view
+       **/
+      BitVectorView slice( size_type offset, size_type width ) const {
+        assert( offset + width <= _width );
+        BitVectorView ret(*this);
+        ret._offset += offset;
+        ret._width = width;
+        return ret;
+      }
+
+      /**
+       * lo in the least and hi in the most significant bits
+       **/
+      static BitVectorView concat( BitVectorView const & lo, BitVectorView const & hi ) {
+        if ( hi.empty() ) return lo;
+        if ( lo.empty() ) return hi;
+        if ( lo._node == hi._node && lo._offset + lo._width == hi._offset ) {
+          BitVectorView ret(lo);
+          ret._width += hi._width;
+          return ret;
+        }
+        BitVectorView ret;
+        ret._node.reset( new Node(lo, hi) );
+        ret._width = lo._width + hi._width;
+        // bound the recursion of flattening and destruction
+        if ( ret._node->depth > 32 ) {
+          ret._node->flatten();
+        }
+        return ret;
+      }
+
+      bool operator== ( BitVectorView const & other ) const {
+        if ( _width != other._width ) return false;
+        if ( _node == other._node && _offset == other._offset ) return true;
+        return std::equal( begin(), end(), other.begin() );
+      }
+
+      bool operator!= ( BitVectorView const & other ) const {
+        return !(*this == other);
+      }
+
+    private:
+      Bit const * data() const {
+        if ( !_node ) return 0;
+        _node->flatten();
+        return _node->bits.empty() ? 0 : &_node->bits[0];
+      }
+
+      Bit * mutable_data() {
+        if ( _node && !_node.unique() ) {
+          BitVectorView const & self = *this;
+          _node.reset( new Node(self.begin(), self.end()) );
+          _offset = 0;
+        }
+        return const_cast<Bit *>( data() );
+      }
+
+    private:
+      boost::shared_ptr<Node> _node;
+      size_type _offset;
+      size_type _width;
+  };
+
+  /**
+   * storage of a BitVectorView: either the bits themselves or, until
+   * first accessed, the two views of a concatenation.
+   **/
+  template <typename Bit>
+  struct BitVectorView<Bit>::Node {
+    Node( size_type width, Bit const & fill )
+      : bits(width, fill), depth(0)
+    {}
+
+    Node( Bit const * first, Bit const * last )
+      : bits(first, last), depth(0)
+    {}
+
+    Node( BitVectorView const & lo, BitVectorView const & hi )
+      : lo(lo), hi(hi)
+      , depth( 1 + std::max(lo._node->depth, hi._node->depth) )
+    {}
+
+    void flatten() {
+      if ( lo.empty() ) return;
+      BitVectorView const & l = lo;
+      BitVectorView const & h = hi;
+      bits.reserve( l.size() + h.size() );
+      bits.insert( bits.end(), l.begin(), l.end() );
+      bits.insert( bits.end(), h.begin(), h.end() );
+      lo = BitVectorView();
+      hi = BitVectorView();
+      depth = 0;
+    }
+
+    std::vector<Bit> bits;
+    BitVectorView lo;
+    BitVectorView hi;
+    // longest chain of concatenations below this node
+    unsigned depth;
+  };
+
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
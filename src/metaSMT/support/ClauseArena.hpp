@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../tags/SAT.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace metaSMT {
+  namespace SAT {
+
+    /**
+     * @brief a range of clauses in a ClauseArena.
+     *
+     * The literals of all clauses are stored contiguously, every clause is
+     * terminated by the invalid literal 0. SAT backends receive the clauses
+     * of SAT_Clause and SAT_Aiger in this form through
+     * add_clauses ( clause_span const& ).
+     **/
+    struct clause_span {
+      tag::lit_tag const * first;
+      tag::lit_tag const * last;
+
+      bool empty() const { return first == last; }
+    };
+
+    /**
+     * @brief contiguous, 0-terminated clause buffer.
+     *
+     * The encoders append their clauses here instead of allocating a
+     * vector per clause and hand them to the backend in batches.
+     **/
+    class ClauseArena {
+      public:
+        ClauseArena()
+          : _clauses(0)
+        {}
+
+        void push( tag::lit_tag a ) {
+          _lits.push_back( a );
+          terminate();
+        }
+
+        void push( tag::lit_tag a, tag::lit_tag b ) {
+          _lits.push_back( a );
+          _lits.push_back( b );
+          terminate();
+        }
+
+        void push( tag::lit_tag a, tag::lit_tag b, tag::lit_tag c ) {
+          _lits.push_back( a );
+          _lits.push_back( b );
+          _lits.push_back( c );
+          terminate();
+        }
+
+        void push( std::vector<tag::lit_tag> const & cls ) {
+          _lits.insert( _lits.end(), cls.begin(), cls.end() );
+          terminate();
+        }
+
+        clause_span span() const {
+          clause_span s = { 0, 0 };
+          if ( !_lits.empty() ) {
+            s.first = &_lits[0];
+            s.last = s.first + _lits.size();
+          }
+          return s;
+        }
+
+        bool empty() const { return _clauses == 0; }
+
+        // number of clauses in the arena
+        std::size_t size() const { return _clauses; }
+
+        // number of stored literals including the terminators
+        std::size_t literals() const { return _lits.size(); }
+
+        /**
+         * removes all clauses but keeps the memory for the next batch
+         **/
+        void clear() {
+          _lits.clear();
+          _clauses = 0;
+        }
+
+      private:
+        void terminate() {
+          tag::lit_tag zero = { 0 };
+          _lits.push_back( zero );
+          ++_clauses;
+        }
+
+      private:
+        std::vector<tag::lit_tag> _lits;
+        std::size_t _clauses;
+    };
+
+  } // namespace SAT
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
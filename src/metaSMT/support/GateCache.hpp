@@ -0,0 +1,394 @@
+#pragma once
+
+#include "../tags/Logic.hpp"
+#include "../Features.hpp"
+
+#include <boost/any.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/mpl/assert.hpp>
+#include <boost/tr1/unordered_map.hpp>
+
+namespace metaSMT {
+
+  /**
+   * @brief hash function for backend results used in the GateCache.
+   *
+   * The default uses boost::hash. Backends whose result_type is not
+   * hashable specialize this template.
+   **/
+  template <typename Result>
+  struct gate_hash {
+    std::size_t operator() (Result const & r) const {
+      return boost::hash<Result>()(r);
+    }
+  };
+
+  /**
+   * @brief counters reported by the GateCache.
+   *
+   * lookups counts all gate requests, hits the requests answered from the
+   * hash table, simplified the requests answered by a trivial rule
+   * (constants, x&x, x&!x, ...) and gates the gates actually created.
+   **/
+  struct GateCacheStatistics {
+    GateCacheStatistics()
+      : lookups(0), hits(0), simplified(0), gates(0)
+    {}
+
+    double hit_rate() const {
+      return lookups == 0 ? 0.0 : double(hits + simplified) / lookups;
+    }
+
+    unsigned long lookups;
+    unsigned long hits;
+    unsigned long simplified;
+    unsigned long gates;
+  };
+
+  struct gate_cache_statistics_cmd { typedef GateCacheStatistics result_type; };
+
+  template <typename Context_ >
+  GateCacheStatistics gate_cache_statistics( Context_ &ctx ) {
+    BOOST_MPL_ASSERT_MSG(
+      ( features::supports<Context_, gate_cache_statistics_cmd>::value )
+    , context_does_not_support_gate_cache_statistics_api
+    , ()
+    );
+    return ctx.command(gate_cache_statistics_cmd());
+  }
+
+  /**
+   * @brief constant propagation and structural hashing of bit-level gates
+   *
+   * GateCache wraps a predicate solver and forwards all gates to it.
+   * The true and false results are remembered, so every and/or/xor/ite
+   * gate with a constant (or twice the same) operand is folded instead
+   * of being created. When enabled, the remaining gates are looked up in
+   * a hash table keyed on the (commutatively normalized) operands, so the
+   * same gate is never created twice.
+   **/
+  template <typename PredicateSolver>
+  class GateCache {
+    public:
+      typedef typename PredicateSolver::result_type result_type;
+
+    private:
+      enum Op { NOT, AND, NAND, OR, NOR, XOR, XNOR, IMPLIES, ITE };
+
+      struct Gate {
+        Gate( Op op
+          , result_type a = result_type()
+          , result_type b = result_type()
+          , result_type c = result_type()
+        ) : op(op), a(a), b(b), c(c) {}
+
+        bool operator== (Gate const & other) const {
+          return op == other.op && a == other.a && b == other.b && c == other.c;
+        }
+
+        Op op;
+        result_type a, b, c;
+      };
+
+      struct GateHash {
+        std::size_t operator() (Gate const & g) const {
+          gate_hash<result_type> h;
+          std::size_t seed = g.op;
+          boost::hash_combine(seed, h(g.a));
+          boost::hash_combine(seed, h(g.b));
+          boost::hash_combine(seed, h(g.c));
+          return seed;
+        }
+      };
+
+      typedef std::tr1::unordered_map<Gate, result_type, GateHash> Table;
+
+    public:
+      GateCache( PredicateSolver & solver )
+        : _solver(solver)
+        , _enabled(false)
+        , _has_true(false)
+        , _has_false(false)
+      {}
+
+      void enable( bool enabled ) {
+        if ( !enabled ) {
+          _table.clear();
+        }
+        _enabled = enabled;
+      }
+
+      bool enabled() const {
+        return _enabled;
+      }
+
+      bool is_true( result_type const & a ) const {
+        return _has_true && a == _true;
+      }
+
+      bool is_false( result_type const & a ) const {
+        return _has_false && a == _false;
+      }
+
+      /**
+       * true if a is the true or false result
+       **/
+      bool is_constant( result_type const & a ) const {
+        return is_true(a) || is_false(a);
+      }
+
+      GateCacheStatistics const & statistics() const {
+        return _stats;
+      }
+
+      result_type operator() (logic::tag::true_tag const & tag, boost::any arg) {
+        if ( !_has_true ) {
+          _true = _solver(tag, arg);
+          _has_true = true;
+        }
+        return _true;
+      }
+
+      result_type operator() (logic::tag::false_tag const & tag, boost::any arg) {
+        if ( !_has_false ) {
+          _false = _solver(tag, arg);
+          _has_false = true;
+        }
+        return _false;
+      }
+
+      result_type operator() (logic::tag::not_tag const & tag, result_type a) {
+        ++_stats.lookups;
+        if ( is_true(a) ) return simplified( false_() );
+        if ( is_false(a) ) return simplified( true_() );
+        if ( !_enabled ) {
+          ++_stats.gates;
+          return _solver(tag, a);
+        }
+        Gate g(NOT, a);
+        typename Table::const_iterator it = _table.find(g);
+        if ( it != _table.end() ) {
+          ++_stats.hits;
+          return it->second;
+        }
+        result_type ret = _solver(tag, a);
+        ++_stats.gates;
+        _table.insert( std::make_pair(g, ret) );
+        // not(not(a)) is a
+        _table.insert( std::make_pair(Gate(NOT, ret), a) );
+        return ret;
+      }
+
+      result_type operator() (logic::tag::and_tag const & tag, result_type a, result_type b) {
+        ++_stats.lookups;
+        result_type ret;
+        if ( simplify_and(a, b, ret) ) return simplified(ret);
+        return commutative(tag, AND, a, b);
+      }
+
+      result_type operator() (logic::tag::nand_tag const & tag, result_type a, result_type b) {
+        ++_stats.lookups;
+        result_type ret;
+        if ( simplify_and(a, b, ret) ) return simplified( not_(ret) );
+        return commutative(tag, NAND, a, b);
+      }
+
+      result_type operator() (logic::tag::or_tag const & tag, result_type a, result_type b) {
+        ++_stats.lookups;
+        result_type ret;
+        if ( simplify_or(a, b, ret) ) return simplified(ret);
+        return commutative(tag, OR, a, b);
+      }
+
+      result_type operator() (logic::tag::nor_tag const & tag, result_type a, result_type b) {
+        ++_stats.lookups;
+        result_type ret;
+        if ( simplify_or(a, b, ret) ) return simplified( not_(ret) );
+        return commutative(tag, NOR, a, b);
+      }
+
+      result_type operator() (logic::tag::xor_tag const & tag, result_type a, result_type b) {
+        ++_stats.lookups;
+        result_type ret;
+        if ( simplify_xor(a, b, ret) ) return simplified(ret);
+        return commutative(tag, XOR, a, b);
+      }
+
+      result_type operator() (logic::tag::xnor_tag const & tag, result_type a, result_type b) {
+        ++_stats.lookups;
+        result_type ret;
+        if ( simplify_xor(a, b, ret) ) return simplified( not_(ret) );
+        return commutative(tag, XNOR, a, b);
+      }
+
+      result_type operator() (logic::tag::nequal_tag const & tag, result_type a, result_type b) {
+        return (*this)(logic::tag::xor_tag(), a, b);
+      }
+
+      result_type operator() (logic::tag::equal_tag const & tag, result_type a, result_type b) {
+        return (*this)(logic::tag::xnor_tag(), a, b);
+      }
+
+      result_type operator() (logic::tag::implies_tag const & tag, result_type a, result_type b) {
+        ++_stats.lookups;
+        if ( is_false(a) || is_true(b) || a == b ) return simplified( true_() );
+        if ( is_true(a) ) return simplified(b);
+        if ( is_false(b) ) return simplified( not_(a) );
+        return lookup(tag, Gate(IMPLIES, a, b));
+      }
+
+      result_type operator() (logic::tag::ite_tag const & tag, result_type c, result_type t, result_type e) {
+        ++_stats.lookups;
+        if ( is_true(c) || t == e ) return simplified(t);
+        if ( is_false(c) ) return simplified(e);
+        if ( is_true(t) && is_false(e) ) return simplified(c);
+        if ( is_false(t) && is_true(e) ) return simplified( not_(c) );
+        if ( c == t || is_true(t) ) return simplified( or_(c, e) );
+        if ( c == e || is_false(e) ) return simplified( and_(c, t) );
+        if ( is_false(t) ) return simplified( and_(not_(c), e) );
+        if ( is_true(e) ) return simplified( or_(not_(c), t) );
+        if ( is_negation(c, e) ) return simplified( or_(t, e) );
+        if ( is_negation(c, t) ) return simplified( and_(t, e) );
+        return lookup(tag, Gate(ITE, c, t, e));
+      }
+
+      ////////////////////////////////////
+      // everything else is forwarded   //
+      ////////////////////////////////////
+
+      template <typename Tag, typename Any>
+      result_type operator() (Tag const & tag, Any arg) {
+        return _solver(tag, arg);
+      }
+
+      template <typename Tag>
+      result_type operator() (Tag const & tag, result_type a) {
+        return _solver(tag, a);
+      }
+
+      template <typename Tag>
+      result_type operator() (Tag const & tag, result_type a, result_type b) {
+        return _solver(tag, a, b);
+      }
+
+      template <typename Tag>
+      result_type operator() (Tag const & tag, result_type a, result_type b, result_type c) {
+        return _solver(tag, a, b, c);
+      }
+
+    private:
+      template <typename Tag>
+      result_type lookup( Tag const & tag, Gate const & g ) {
+        typename Table::const_iterator it = _table.find(g);
+        if ( it != _table.end() ) {
+          ++_stats.hits;
+          return it->second;
+        }
+        result_type ret = g.op == ITE
+          ? _solver(tag, g.a, g.b, g.c)
+          : _solver(tag, g.a, g.b);
+        ++_stats.gates;
+        if ( _enabled ) {
+          _table.insert( std::make_pair(g, ret) );
+        }
+        return ret;
+      }
+
+      template <typename Tag>
+      result_type commutative( Tag const & tag, Op op, result_type a, result_type b ) {
+        gate_hash<result_type> h;
+        if ( h(b) < h(a) ) {
+          return lookup(tag, Gate(op, b, a));
+        }
+        return lookup(tag, Gate(op, a, b));
+      }
+
+      bool simplify_and( result_type const & a, result_type const & b, result_type & ret ) {
+        if ( is_false(a) || is_false(b) || is_negation(a, b) ) {
+          ret = false_();
+        } else if ( is_true(a) || a == b ) {
+          ret = b;
+        } else if ( is_true(b) ) {
+          ret = a;
+        } else {
+          return false;
+        }
+        return true;
+      }
+
+      bool simplify_or( result_type const & a, result_type const & b, result_type & ret ) {
+        if ( is_true(a) || is_true(b) || is_negation(a, b) ) {
+          ret = true_();
+        } else if ( is_false(a) || a == b ) {
+          ret = b;
+        } else if ( is_false(b) ) {
+          ret = a;
+        } else {
+          return false;
+        }
+        return true;
+      }
+
+      bool simplify_xor( result_type const & a, result_type const & b, result_type & ret ) {
+        if ( a == b ) {
+          ret = false_();
+        } else if ( is_negation(a, b) ) {
+          ret = true_();
+        } else if ( is_false(a) ) {
+          ret = b;
+        } else if ( is_false(b) ) {
+          ret = a;
+        } else if ( is_true(a) ) {
+          ret = not_(b);
+        } else if ( is_true(b) ) {
+          ret = not_(a);
+        } else {
+          return false;
+        }
+        return true;
+      }
+
+      bool is_negation( result_type const & a, result_type const & b ) const {
+        typename Table::const_iterator it = _table.find( Gate(NOT, a) );
+        return it != _table.end() && it->second == b;
+      }
+
+      result_type simplified( result_type const & r ) {
+        ++_stats.simplified;
+        return r;
+      }
+
+      result_type true_() {
+        return (*this)(logic::tag::true_tag(), boost::any());
+      }
+
+      result_type false_() {
+        return (*this)(logic::tag::false_tag(), boost::any());
+      }
+
+      result_type not_( result_type const & a ) {
+        return (*this)(logic::tag::not_tag(), a);
+      }
+
+      result_type and_( result_type const & a, result_type const & b ) {
+        return (*this)(logic::tag::and_tag(), a, b);
+      }
+
+      result_type or_( result_type const & a, result_type const & b ) {
+        return (*this)(logic::tag::or_tag(), a, b);
+      }
+
+    private:
+      PredicateSolver & _solver;
+      bool _enabled;
+      bool _has_true;
+      bool _has_false;
+      result_type _true;
+      result_type _false;
+      Table _table;
+      GateCacheStatistics _stats;
+  };
+
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
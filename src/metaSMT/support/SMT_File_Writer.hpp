@@ -30,30 +30,30 @@ namespace metaSMT {
     {}
 
     inline void operator()(bvtags::zero_extend_tag const &tag) const {
-      boost::any arg = boost::get(boost::vertex_arg, g_, v_);
+      boost::any arg = g_.arg(v_);
       unsigned long width = boost::any_cast<unsigned long>(arg);
       outfile_ << "(zero_extend[" << width << "] ";
-      BOOST_FOREACH (SMT_Edge e, out_edges(v_, g_)) {
-        print_SMT_Expression(outfile_, g_, target(e, g_));
+      for (unsigned i = 0; i < g_.arity(v_); ++i) {
+        print_SMT_Expression(outfile_, g_, g_.child(v_, i));
       }
       outfile_ << ')';
     }
 
     inline void operator()(bvtags::bvbin_tag const &tag) const {
-      boost::any arg = boost::get(boost::vertex_arg, g_, v_);
+      boost::any arg = g_.arg(v_);
       std::string bin_const = boost::any_cast<std::string>(arg);
       outfile_ << "(bvbin" << bin_const << ")";
     }
 
     inline void operator()(bvtags::bvhex_tag const &tag) const {
-      boost::any arg = boost::get(boost::vertex_arg, g_, v_);
+      boost::any arg = g_.arg(v_);
       std::string hex_const = boost::any_cast<std::string>(arg);
       outfile_ << "(bvhex" << hex_const << ")";
     }
 
     inline void operator()(bvtags::bvsint_tag const &tag) const {
       typedef boost::tuple<long, unsigned long> tuple_type;
-      boost::any arg = boost::get(boost::vertex_arg, g_, v_);
+      boost::any arg = g_.arg(v_);
       tuple_type const tuple = boost::any_cast<tuple_type>(arg);
       unsigned long const width = tuple.get<1>();
       boost::dynamic_bitset<> bv(width, tuple.get<0>());
@@ -63,50 +63,50 @@ namespace metaSMT {
 
     inline void operator()(bvtags::bvuint_tag const &tag) const {
       typedef boost::tuple<unsigned long, unsigned long> tuple_type;
-      boost::any arg = boost::get(boost::vertex_arg, g_, v_);
+      boost::any arg = g_.arg(v_);
       tuple_type tuple = boost::any_cast<tuple_type>(arg);
       outfile_ << "(bv" << tuple.get<0>() << "[" << tuple.get<1>() << "])";
     }
 
     inline void operator()(bvtags::extract_tag const &tag) const {
       typedef boost::tuple<unsigned long, unsigned long> tuple_type;
-      boost::any arg = boost::get(boost::vertex_arg, g_, v_);
+      boost::any arg = g_.arg(v_);
       tuple_type tuple = boost::any_cast<tuple_type>(arg);
       outfile_ << "(extract[" << tuple.get<0>() << ':' << tuple.get<1>() << "] ";
-      BOOST_FOREACH (SMT_Edge e, out_edges(v_, g_)) {
-        print_SMT_Expression(outfile_, g_, target(e, g_));
+      for (unsigned i = 0; i < g_.arity(v_); ++i) {
+        print_SMT_Expression(outfile_, g_, g_.child(v_, i));
       }
       outfile_ << ")";
     }
 
     inline void operator()(predtags::nequal_tag const &tag) const {
       outfile_ << "(not (=";
-      BOOST_FOREACH (SMT_Edge e, out_edges(v_, g_)) {
-        print_SMT_Expression(outfile_, g_, target(e, g_));
+      for (unsigned i = 0; i < g_.arity(v_); ++i) {
+        print_SMT_Expression(outfile_, g_, g_.child(v_, i));
       }
       outfile_ << "))";
     }
 
     inline void operator()(predtags::nand_tag const &tag) const {
       outfile_ << "(not (and";
-      BOOST_FOREACH (SMT_Edge e, out_edges(v_, g_)) {
-        print_SMT_Expression(outfile_, g_, target(e, g_));
+      for (unsigned i = 0; i < g_.arity(v_); ++i) {
+        print_SMT_Expression(outfile_, g_, g_.child(v_, i));
       }
       outfile_ << "))";
     }
 
     inline void operator()(predtags::nor_tag const &tag) const {
       outfile_ << "(not (or";
-      BOOST_FOREACH (SMT_Edge e, out_edges(v_, g_)) {
-        print_SMT_Expression(outfile_, g_, target(e, g_));
+      for (unsigned i = 0; i < g_.arity(v_); ++i) {
+        print_SMT_Expression(outfile_, g_, g_.child(v_, i));
       }
       outfile_ << "))";
     }
 
     inline void operator()(predtags::xnor_tag const &tag) const {
       outfile_ << "(not (xor";
-      BOOST_FOREACH (SMT_Edge e, out_edges(v_, g_)) {
-        print_SMT_Expression(outfile_, g_, target(e, g_));
+      for (unsigned i = 0; i < g_.arity(v_); ++i) {
+        print_SMT_Expression(outfile_, g_, g_.child(v_, i));
       }
       outfile_ << "))";
     }
@@ -130,11 +130,11 @@ namespace metaSMT {
     operator()(T const &t) const {
       typedef typename mpl::at< SMT_NameMap, T >::type name;
 
-      if (out_degree(v_, g_) != 0) {
+      if (g_.arity(v_) != 0) {
         outfile_ << '(' << mpl::c_str<name>::value;
-        BOOST_FOREACH (SMT_Edge e, out_edges(v_, g_)) {
+        for (unsigned i = 0; i < g_.arity(v_); ++i) {
           outfile_ << ' ';
-          print_SMT_Expression(outfile_, g_, target(e, g_));
+          print_SMT_Expression(outfile_, g_, g_.child(v_, i));
         }
         outfile_ << ')';
       } else {
@@ -160,7 +160,7 @@ namespace metaSMT {
                                    SMT_Graph const &g,
                                    SMT_Expression const &v) {
     outfile << ' ';
-    metaSMT::Tag tag = boost::get(boost::vertex_tag, g, v);
+    metaSMT::Tag tag = g.tag(v);
     boost::apply_visitor(Vertex_Printer(outfile, g, v), tag);
   }
 
@@ -207,8 +207,8 @@ namespace metaSMT {
       << " :logic QF_BV\n"
     ;
 
-    BOOST_FOREACH (SMT_Expression v, vertices(g)) {
-      metaSMT::Tag tag = boost::get(boost::vertex_tag, g, v);
+    for (SMT_Expression v = 0; v < g.size(); ++v) {
+      metaSMT::Tag tag = g.tag(v);
       boost::apply_visitor(SMT_Declaration_Printer(outfile, g, v), tag);
     }
 
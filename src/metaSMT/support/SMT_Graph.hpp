@@ -2,44 +2,268 @@
 
 #include "../tags/Logics.hpp"
 
-#include "disable_warnings.hpp"
-#include <boost/graph/graph_traits.hpp>
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/function.hpp>
 #include <boost/any.hpp>
-#include "enable_warnings.hpp"
+#include <boost/cstdint.hpp>
+#include <boost/mpl/for_each.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/variant/static_visitor.hpp>
 
-namespace boost {
-  enum edge_input_t { edge_input };
-  BOOST_INSTALL_PROPERTY (edge, input);
+#include <cassert>
+#include <string>
+#include <vector>
 
-  enum vertex_tag_t { vertex_tag };
-  BOOST_INSTALL_PROPERTY (vertex, tag);
+namespace metaSMT {
 
-  enum vertex_arg_t { vertex_arg };
-  BOOST_INSTALL_PROPERTY (vertex, arg);
-}
+  /**
+   * @brief expression DAG of the Graph_Context.
+   *
+   * The nodes are stored as a structure of arrays and identified by
+   * their 32 bit index, children always have smaller indices than their
+   * parents. Per node the graph keeps
+   *   - the index of its tag in the metaSMT::Tag variant (one byte),
+   *   - up to MAX_ARITY children inline,
+   *   - one data word that refers to a side table: the tags with data
+   *     (variables), the parameters of constants, extract and extend,
+   *     and the strings of bvbin/bvhex constants.
+   * Nothing is allocated per node besides the entries of the arrays.
+   **/
+  class SMT_Graph {
+    public:
+      typedef boost::uint32_t node_type;
 
-namespace metaSMT {
-  
-  /* define properties on edges */
-  typedef boost::property <boost::edge_input_t, size_t> edge_input_property;
-  typedef edge_input_property SMT_Edge_t;
+      enum { MAX_ARITY = 3 };
+
+      // the child slot of a node with a smaller arity
+      static node_type none() { return node_type(-1); }
+
+      /**
+       * adds a node with tag and children a, b, c (as far as needed for
+       * arity). p0 and p1 are the parameters of extract (upper, lower),
+       * zero_extend/sign_extend (width), bvuint and bvsint (value,
+       * width).
+       **/
+      node_type add( Tag const & tag, unsigned arity = 0
+        , node_type a = none(), node_type b = none(), node_type c = none()
+        , boost::uint64_t p0 = 0, boost::uint64_t p1 = 0 )
+      {
+        assert( arity <= MAX_ARITY );
+        const node_type n = _tags.size();
+        _tags.push_back( tag.which() );
+        _children.push_back( arity > 0 ? a : none() );
+        _children.push_back( arity > 1 ? b : none() );
+        _children.push_back( arity > 2 ? c : none() );
+
+        has_data data;
+        if ( boost::apply_visitor( data, tag ) ) {
+          _data.push_back( _variables.size() );
+          _variables.push_back( tag );
+        } else if ( parameters( tag.which() ) ) {
+          _data.push_back( _parameters.size() );
+          _parameters.push_back( p0 );
+          _parameters.push_back( p1 );
+        } else {
+          _data.push_back( 0 );
+        }
+        return n;
+      }
+
+      /**
+       * adds a bvbin or bvhex constant
+       **/
+      node_type add( Tag const & tag, std::string const & value ) {
+        const node_type n = add( tag );
+        _data[n] = _strings.size();
+        _strings.push_back( value );
+        return n;
+      }
+
+      std::size_t size() const {
+        return _tags.size();
+      }
+
+      Tag tag( node_type n ) const {
+        has_data data;
+        Tag const & t = prototypes()[ _tags[n] ];
+        return boost::apply_visitor( data, t ) ? _variables[ _data[n] ] : t;
+      }
+
+      // whether n is a (predicate, bit-vector or array) variable
+      bool variable( node_type n ) const {
+        has_data data;
+        return boost::apply_visitor( data, prototypes()[ _tags[n] ] );
+      }
+
+      unsigned arity( node_type n ) const {
+        unsigned k = 0;
+        while ( k < MAX_ARITY && _children[ MAX_ARITY * n + k ] != none() ) {
+          ++k;
+        }
+        return k;
+      }
+
+      node_type child( node_type n, unsigned i ) const {
+        return _children[ MAX_ARITY * n + i ];
+      }
+
+      boost::uint64_t parameter( node_type n, unsigned i ) const {
+        return _parameters[ _data[n] + i ];
+      }
+
+      std::string const & string( node_type n ) const {
+        return _strings[ _data[n] ];
+      }
+
+      /**
+       * the argument of a node in the form the backends expect:
+       * tuple<unsigned long, unsigned long> for extract and bvuint,
+       * tuple<long, unsigned long> for bvsint, unsigned long for the
+       * extensions, std::string for bvbin/bvhex, empty otherwise.
+       **/
+      boost::any arg( node_type n ) const {
+        const int t = _tags[n];
+        if ( t == index<logic::QF_BV::tag::extract_tag>()
+          || t == index<logic::QF_BV::tag::bvuint_tag>() ) {
+          return boost::tuple<unsigned long, unsigned long>(
+              parameter(n, 0), parameter(n, 1) );
+        }
+        if ( t == index<logic::QF_BV::tag::bvsint_tag>() ) {
+          return boost::tuple<long, unsigned long>(
+              long( parameter(n, 0) ), parameter(n, 1) );
+        }
+        if ( t == index<logic::QF_BV::tag::zero_extend_tag>()
+          || t == index<logic::QF_BV::tag::sign_extend_tag>() ) {
+          return static_cast<unsigned long>( parameter(n, 0) );
+        }
+        if ( t == index<logic::QF_BV::tag::bvbin_tag>()
+          || t == index<logic::QF_BV::tag::bvhex_tag>() ) {
+          return string(n);
+        }
+        return boost::any();
+      }
+
+      /**
+       * removes the nodes that are not live and renumbers the others in
+       * their order, so children keep smaller indices than their parents.
+       * renumbering receives the new index of every old node, none() if
+       * it was removed. The arrays are reallocated to their new size.
+       **/
+      void compact( std::vector<bool> const & live
+                  , std::vector<node_type> & renumbering )
+      {
+        renumbering.assign( size(), none() );
+        node_type count = 0;
+        for ( node_type n = 0; n < size(); ++n ) {
+          if ( live[n] ) {
+            renumbering[n] = count++;
+          }
+        }
+
+        SMT_Graph g;
+        g._tags.reserve( count );
+        g._children.reserve( MAX_ARITY * count );
+        g._data.reserve( count );
+        for ( node_type n = 0; n < size(); ++n ) {
+          if ( !live[n] ) continue;
+          const int t = _tags[n];
+          node_type c[MAX_ARITY];
+          for ( unsigned i = 0; i < MAX_ARITY; ++i ) {
+            const node_type old = child(n, i);
+            c[i] = old == none() ? none() : renumbering[old];
+          }
+          if ( t == index<logic::QF_BV::tag::bvbin_tag>()
+            || t == index<logic::QF_BV::tag::bvhex_tag>() ) {
+            g.add( tag(n), string(n) );
+          } else if ( parameters(t) ) {
+            g.add( tag(n), arity(n), c[0], c[1], c[2]
+              , parameter(n, 0), parameter(n, 1) );
+          } else {
+            g.add( tag(n), arity(n), c[0], c[1], c[2] );
+          }
+        }
+        g._variables = std::vector<Tag>( g._variables.begin(), g._variables.end() );
+        g._parameters = std::vector<boost::uint64_t>( g._parameters.begin(), g._parameters.end() );
+        g._strings = std::vector<std::string>( g._strings.begin(), g._strings.end() );
+        swap( g );
+      }
+
+      void swap( SMT_Graph & other ) {
+        _tags.swap( other._tags );
+        _children.swap( other._children );
+        _data.swap( other._data );
+        _variables.swap( other._variables );
+        _parameters.swap( other._parameters );
+        _strings.swap( other._strings );
+      }
+
+      /**
+       * bytes used by the arrays of the graph
+       **/
+      std::size_t memory() const {
+        return _tags.capacity() * sizeof(unsigned char)
+          + _children.capacity() * sizeof(node_type)
+          + _data.capacity() * sizeof(boost::uint32_t)
+          + _variables.capacity() * sizeof(Tag)
+          + _parameters.capacity() * sizeof(boost::uint64_t)
+          + _strings.capacity() * sizeof(std::string);
+      }
+
+    private:
+      // whether a tag carries data beyond its type
+      struct has_data : boost::static_visitor<bool> {
+        template <typename T>
+        bool operator() (T const &) const { return false; }
+        bool operator() (logic::tag::var_tag const &) const { return true; }
+        bool operator() (logic::QF_BV::tag::var_tag const &) const { return true; }
+        bool operator() (logic::Array::tag::array_var_tag const &) const { return true; }
+      };
+
+      struct push_prototype {
+        explicit push_prototype( std::vector<Tag> & v ) : v(v) {}
+        template <typename T>
+        void operator() (T const & t) const { v.push_back( Tag(t) ); }
+        std::vector<Tag> & v;
+      };
+
+      static std::vector<Tag> make_prototypes() {
+        std::vector<Tag> tags;
+        boost::mpl::for_each< Tag::types >( push_prototype(tags) );
+        return tags;
+      }
+
+      // a default constructed Tag of every alternative, by index
+      static std::vector<Tag> const & prototypes() {
+        static const std::vector<Tag> tags = make_prototypes();
+        return tags;
+      }
+
+      template <typename T>
+      static int index() {
+        static const int i = Tag( T() ).which();
+        return i;
+      }
 
-  /* define properties on Vertices */
-  typedef boost::property <boost::vertex_arg_t, boost::any > vertex_arg_property;
-  typedef boost::property <boost::vertex_tag_t, metaSMT::Tag, vertex_arg_property> vertex_tag_property;
-  typedef vertex_tag_property SMT_Vertex_t;
+      static bool parameters( int t ) {
+        return t == index<logic::QF_BV::tag::extract_tag>()
+          || t == index<logic::QF_BV::tag::zero_extend_tag>()
+          || t == index<logic::QF_BV::tag::sign_extend_tag>()
+          || t == index<logic::QF_BV::tag::bvuint_tag>()
+          || t == index<logic::QF_BV::tag::bvsint_tag>();
+      }
 
-  typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS
-                              , SMT_Vertex_t
-                              , SMT_Edge_t
-                              > SMT_Graph  ;
+    private:
+      std::vector<unsigned char> _tags;
+      // MAX_ARITY children per node, none() if unused
+      std::vector<node_type> _children;
+      // index into _variables, _parameters or _strings
+      std::vector<boost::uint32_t> _data;
+      std::vector<Tag> _variables;
+      // two per node with parameters
+      std::vector<boost::uint64_t> _parameters;
+      std::vector<std::string> _strings;
+  };
 
-  typedef boost::graph_traits<SMT_Graph >::vertex_descriptor SMT_Expression;
-  typedef boost::graph_traits<SMT_Graph >::edge_descriptor   SMT_Edge;
+  typedef SMT_Graph::node_type SMT_Expression;
 
-  
 } /* namespace metaSMT */
 
 //  vim: ft=cpp:ts=2:sw=2:expandtab
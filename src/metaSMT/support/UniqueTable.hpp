@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace metaSMT {
+
+  /**
+   * @brief open addressing hash table for hash consing.
+   *
+   * Maps keys (node signatures) to values (nodes) with linear probing
+   * in a power of two sized slot array. Every slot caches the hash of
+   * its key, so a probe only compares keys with equal hashes. Entries
+   * are never removed one by one (see retain); the table grows to keep
+   * the load below one half.
+   **/
+  template < typename Key, typename Value, typename Hash, typename Equal = std::equal_to<Key> >
+  class UniqueTable {
+    private:
+      struct Slot {
+        Slot() : used(false), hash(0), key(), value() {}
+
+        bool used;
+        std::size_t hash;
+        Key key;
+        Value value;
+      };
+
+    public:
+      UniqueTable()
+        : _slots(16)
+        , _size(0)
+      {}
+
+      /**
+       * the value of key or 0 if there is none
+       **/
+      Value const * find( Key const & key ) const {
+        const std::size_t h = _hash(key);
+        const std::size_t mask = _slots.size() - 1;
+        for ( std::size_t i = h & mask; _slots[i].used; i = (i + 1) & mask ) {
+          Slot const & s = _slots[i];
+          if ( s.hash == h && _equal(s.key, key) ) {
+            return &s.value;
+          }
+        }
+        return 0;
+      }
+
+      /**
+       * adds key, which must not be in the table yet
+       **/
+      void insert( Key const & key, Value const & value ) {
+        if ( 2 * (_size + 1) > _slots.size() ) {
+          grow();
+        }
+        place( _hash(key), key, value );
+        ++_size;
+      }
+
+      std::size_t size() const {
+        return _size;
+      }
+
+      void clear() {
+        _slots.assign( 16, Slot() );
+        _size = 0;
+      }
+
+      /**
+       * keeps the entries for which f(key, value) returns true, f may
+       * change key and value in place. The table is rebuilt.
+       **/
+      template <typename Function>
+      void retain( Function f ) {
+        std::vector<Slot> old( 16 );
+        old.swap( _slots );
+        _size = 0;
+        for ( std::size_t i = 0; i < old.size(); ++i ) {
+          if ( old[i].used && f(old[i].key, old[i].value) ) {
+            insert( old[i].key, old[i].value );
+          }
+        }
+      }
+
+      // bytes used by the slots
+      std::size_t memory() const {
+        return _slots.capacity() * sizeof(Slot);
+      }
+
+    private:
+      void place( std::size_t h, Key const & key, Value const & value ) {
+        const std::size_t mask = _slots.size() - 1;
+        std::size_t i = h & mask;
+        while ( _slots[i].used ) {
+          i = (i + 1) & mask;
+        }
+        Slot & s = _slots[i];
+        s.used = true;
+        s.hash = h;
+        s.key = key;
+        s.value = value;
+      }
+
+      void grow() {
+        std::vector<Slot> old( 2 * _slots.size() );
+        old.swap( _slots );
+        for ( std::size_t i = 0; i < old.size(); ++i ) {
+          if ( old[i].used ) {
+            place( old[i].hash, old[i].key, old[i].value );
+          }
+        }
+      }
+
+    private:
+      std::vector<Slot> _slots;
+      std::size_t _size;
+      Hash _hash;
+      Equal _equal;
+  };
+
+} // namespace metaSMT
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
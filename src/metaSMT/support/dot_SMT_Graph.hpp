@@ -1,7 +1,6 @@
 #pragma once
 
 #include "SMT_Graph.hpp"
-#include <boost/graph/graphviz.hpp>
 #include <boost/variant.hpp>
 #include <boost/tuple/tuple_io.hpp>
 #include <ostream>
@@ -11,7 +10,7 @@ namespace metaSMT {
   struct VertexDecorator
   {
     typedef void result_type;
-    typedef boost::graph_traits<SMT_Graph>::vertex_descriptor VertexT;
+    typedef SMT_Expression VertexT;
 
     VertexDecorator( const SMT_Graph & g, VertexT const & v , std::ostream & out)
       : _g(g), _v(v), out(out) {}
@@ -19,35 +18,34 @@ namespace metaSMT {
     void operator()(logic::QF_BV::tag::bvbin_tag const &) {
       using namespace boost;
       out << "[ label=\"";
-      out << "bvbin(" << any_cast<std::string>(get(vertex_arg, _g, _v)) << ")";
+      out << "bvbin(" << any_cast<std::string>(_g.arg(_v)) << ")";
       out << "\"]";
     }
 
     void operator()(logic::QF_BV::tag::bvhex_tag const &) {
       using namespace boost;
       out << "[ label=\"";
-      out << "bvhex(" << any_cast<std::string>(get(vertex_arg, _g, _v)) << ")";
+      out << "bvhex(" << any_cast<std::string>(_g.arg(_v)) << ")";
       out << "\"]";
     }
 
     void operator()(logic::QF_BV::tag::bvuint_tag const &) {
       using namespace boost;
       out << "[ label=\"";
-      out << "bvuint" << any_cast<tuple< unsigned long, unsigned long> >(get(vertex_arg, _g, _v));
+      out << "bvuint" << any_cast<tuple< unsigned long, unsigned long> >(_g.arg(_v));
       out << "\"]";
     }
 
     void operator()(logic::QF_BV::tag::bvsint_tag const &) {
       using namespace boost;
       out << "[ label=\"";
-      out << "bvsint" << any_cast<tuple< long, unsigned long> >(get(vertex_arg, _g, _v));
+      out << "bvsint" << any_cast<tuple< long, unsigned long> >(_g.arg(_v));
       out << "\"]";
     }
 
     template <typename Tag>
     void operator()(Tag const & t ){
-      using namespace boost;
-      out << "[ label=\"" << out << "\"]";
+      out << "[ label=\"" << t << "\"]";
     }
 
     private:
@@ -56,37 +54,26 @@ namespace metaSMT {
       std::ostream & out;
   };
 
-  struct DotDecorator {
-    DotDecorator(const SMT_Graph & g) 
-      : _g(g) { }
-
-    typedef boost::graph_traits<SMT_Graph>::vertex_descriptor VertexT;
-    typedef boost::graph_traits<SMT_Graph>::edge_descriptor   EdgeT;
-
-    void operator()(std::ostream & out, VertexT n ) {
-      VertexDecorator vd(_g, n, out);
-      boost::apply_visitor(vd, boost::get(boost::vertex_tag, _g, n) );
-    }
-
-    void operator()(std::ostream & out, EdgeT e){
-      using namespace boost;
-      out << "[ label=\"";
-      out << "IN: " << get(edge_input, _g, e);
-      out << "\"]";
+  /**
+   * writes g in graphviz format, the edges point from a node to its
+   * inputs and are labeled with the input position
+   **/
+  inline void write_dot(std::ostream & out, SMT_Graph const & g) {
+    out << "digraph G {\n";
+    for ( SMT_Expression n = 0; n < g.size(); ++n ) {
+      out << n;
+      VertexDecorator vd(g, n, out);
+      Tag tag = g.tag(n);
+      boost::apply_visitor(vd, tag );
+      out << ";\n";
     }
-
-    template <typename T2>
-    void operator()(std::ostream & out, T2) const{
+    for ( SMT_Expression n = 0; n < g.size(); ++n ) {
+      for ( unsigned i = 0; i < g.arity(n); ++i ) {
+        out << n << "->" << g.child(n, i)
+            << " [ label=\"IN: " << i << "\"];\n";
+      }
     }
-
-    private:
-    SMT_Graph const & _g;
-  };
-
-
-  inline void write_dot(std::ostream & out, SMT_Graph & g) {
-    DotDecorator dotDecorator(g);
-    write_graphviz(out, g, dotDecorator, dotDecorator);
+    out << "}\n";
   }
 
 } // namespace metaSMT
@@ -2,6 +2,7 @@
 
 #include <boost/variant.hpp>
 #include <boost/mpl/vector.hpp>
+#include <cstddef>
 
 namespace metaSMT {
 
@@ -18,6 +19,8 @@ namespace metaSMT {
       friend STREAM & operator<< (STREAM & out, lit_tag const & self)
       {  out << "sat_lit[" << self.id  << "]"; return out; }
       bool operator< (lit_tag const & other) const { return id < other.id; }
+      bool operator== (lit_tag const & other) const { return id == other.id; }
+      friend std::size_t hash_value (lit_tag const & self) { return self.id; }
       lit_tag operator- () const { lit_tag l = { -id }; return l; }
       int var() const {return id >= 0 ? id: -id; }
     };
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <metaSMT/API/Options.hpp>
+
+#include <string>
+
+/**
+ * number of clauses that build(ctx, w) and solve(ctx) generate in a new
+ * Context with the option key set to value. Counter is the SAT backend
+ * of Context, it counts the clauses in Counter::clauses.
+ **/
+template <typename Counter, typename Context>
+unsigned count_clauses( std::string const & key, std::string const & value
+                      , void (*build)( Context &, unsigned ), unsigned w )
+{
+  Counter::clauses = 0;
+  Context ctx;
+  metaSMT::set_option( ctx, key, value );
+  build( ctx, w );
+  solve( ctx );
+  return Counter::clauses;
+}
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
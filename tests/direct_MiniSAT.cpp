@@ -17,7 +17,8 @@ struct Solver_Fixture
 
 #include "test_solver.cpp"
 #include "test_QF_BV.cpp"
-// #include "test_Array.cpp"
+#include "test_QF_UF.cpp"
+#include "test_Array.cpp"
 #include "test_group.cpp"
 #include "test_unsat.cpp"
 #include "test_cardinality.cpp"
@@ -18,4 +18,5 @@ struct Solver_Fixture
 // #include "test_Array.cpp"
 // #include "test_group.cpp"
 #include "test_unsat.cpp"
+#include "test_graph_components.cpp"
 #include "test_lazy.cpp"
@@ -13,4 +13,5 @@ struct Solver_Fixture {
 #include "test_solver.cpp"
 #include "test_QF_BV.cpp"
 #include "test_graph_copy.cpp"
+#include "test_graph_components.cpp"
 #include "test_cardinality.cpp"
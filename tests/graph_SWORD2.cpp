@@ -14,5 +14,6 @@ struct Solver_Fixture {
 #include "test_QF_BV.cpp"
 //#include "test_Array.cpp"
 #include "test_graph_copy.cpp"
+#include "test_graph_components.cpp"
 #include "test_unsat.cpp"
 #include "test_lazy.cpp"
@@ -14,6 +14,7 @@ struct Solver_Fixture {
 #include "test_QF_BV.cpp"
 #include "test_Array.cpp"
 #include "test_graph_copy.cpp"
+#include "test_graph_components.cpp"
 #include "test_cardinality.cpp"
 #include "test_lazy.cpp"
 #include "test_stack.cpp"
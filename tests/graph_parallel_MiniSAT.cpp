@@ -0,0 +1,26 @@
+#define BOOST_TEST_MODULE graph_parallel_MiniSAT
+#include <metaSMT/support/default_visitation_unrolling_limit.hpp>
+#include <metaSMT/GraphSolver_Context.hpp>
+#include <metaSMT/concurrent/Parallel_Scheduler.hpp>
+#include <metaSMT/backend/SAT_Clause.hpp>
+#include <metaSMT/backend/MiniSAT.hpp>
+#include <metaSMT/BitBlast.hpp>
+#include <metaSMT/API/Options.hpp>
+
+using namespace metaSMT::solver;
+using namespace metaSMT;
+struct Solver_Fixture
+{
+  typedef GraphSolver_Context< BitBlast < SAT_Clause < MiniSAT > > > ContextType;
+  Solver_Fixture() {
+    set_option( ctx, "graph_components", "1" );
+    ctx.set_scheduler( concurrent::ParallelScheduler(4) );
+  }
+  ContextType ctx ;
+};
+
+#include "test_solver.cpp"
+#include "test_QF_BV.cpp"
+#include "test_unsat.cpp"
+#include "test_graph_components.cpp"
+#include "test_lazy.cpp"
@@ -1,6 +1,7 @@
 #include <metaSMT/frontend/QF_BV.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/mpl/bool.hpp>
 #include <string>
 
 using namespace std;
@@ -10,6 +11,17 @@ using namespace metaSMT::logic::QF_BV;
 namespace proto = boost::proto;
 using boost::dynamic_bitset;
 
+namespace metaSMT {
+  template <typename SolverContext> struct GraphSolver_Context;
+}
+
+// whether Context hands every evaluated expression to its solver
+template <typename Context>
+struct evaluates_eagerly : boost::mpl::true_ {};
+
+template <typename SolverContext>
+struct evaluates_eagerly< GraphSolver_Context<SolverContext> > : boost::mpl::false_ {};
+
 BOOST_FIXTURE_TEST_SUITE(QF_BV, Solver_Fixture )
 
 BOOST_AUTO_TEST_CASE( negative_t )
@@ -636,6 +648,144 @@ BOOST_AUTO_TEST_CASE( bvmul_t )
   BOOST_CHECK_EQUAL( r, zd);
 }
 
+BOOST_AUTO_TEST_CASE( bvmul_encodings )
+{
+  const unsigned w = 6;
+
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  bitvector p = new_bitvector(w);
+
+  set_option( ctx, "bitblast_multiplier", "array" );
+  assertion( ctx, equal( p, bvmul(x, y) ) );
+
+  const char * encodings[] = { "wallace", "dadda", "booth" };
+  for (unsigned i = 0; i < 3; ++i) {
+    set_option( ctx, "bitblast_multiplier", encodings[i] );
+    assumption( ctx, nequal( p, bvmul(x, y) ) );
+    BOOST_CHECK_MESSAGE( !solve(ctx), encodings[i] );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( lazy_arithmetic )
+{
+  const unsigned w = 8;
+
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  bitvector q = new_bitvector(w);
+  bitvector r = new_bitvector(w);
+
+  set_option( ctx, "bitblast_lazy_arithmetic", "1" );
+  assertion( ctx, equal( bvmul(x, y), bvuint(143, w) ) );
+  assertion( ctx, bvugt( x, bvuint(1, w) ) );
+  assertion( ctx, bvugt( y, bvuint(1, w) ) );
+  assertion( ctx, equal( q, bvudiv(x, y) ) );
+  assertion( ctx, equal( r, bvurem(x, y) ) );
+  BOOST_REQUIRE( solve(ctx) );
+
+  unsigned xd = read_value( ctx, x );
+  unsigned yd = read_value( ctx, y );
+  unsigned qd = read_value( ctx, q );
+  unsigned rd = read_value( ctx, r );
+  BOOST_CHECK_EQUAL( (xd*yd) % 256, 143u );
+  BOOST_CHECK_EQUAL( qd, xd/yd );
+  BOOST_CHECK_EQUAL( rd, xd%yd );
+
+  assumption( ctx, nequal( bvmul(x, y), bvmul(y, x) ) );
+  BOOST_CHECK( !solve(ctx) );
+}
+
+BOOST_AUTO_TEST_CASE( polarity_encoding )
+{
+  const unsigned w = 8;
+
+  set_option( ctx, "sat_clause_polarity", "1" );
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  ContextType::result_type lt = evaluate( ctx, bvult(x, y) );
+
+  assumption( ctx, lt );
+  BOOST_REQUIRE( solve(ctx) );
+  unsigned xd = read_value( ctx, x );
+  unsigned yd = read_value( ctx, y );
+  BOOST_CHECK_LT( xd, yd );
+
+  // the other direction of the comparator is added on demand
+  assumption( ctx, Not(lt) );
+  BOOST_REQUIRE( solve(ctx) );
+  xd = read_value( ctx, x );
+  yd = read_value( ctx, y );
+  BOOST_CHECK_GE( xd, yd );
+
+  assertion( ctx, bvugt( x, bvuint(200, w) ) );
+  assertion( ctx, bvult( y, bvuint(100, w) ) );
+  assumption( ctx, lt );
+  BOOST_CHECK( !solve(ctx) );
+}
+
+BOOST_AUTO_TEST_CASE( cone_of_influence )
+{
+  const unsigned w = 8;
+
+  set_option( ctx, "sat_clause_lazy", "1" );
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  // never asserted, but read after solving
+  ContextType::result_type sum = evaluate( ctx, bvadd(x, y) );
+
+  assertion( ctx, equal( bvmul(x, y), bvuint(42, w) ) );
+  BOOST_REQUIRE( solve(ctx) );
+  unsigned xd = read_value( ctx, x );
+  unsigned yd = read_value( ctx, y );
+  unsigned sumd = read_value( ctx, sum );
+  BOOST_CHECK_EQUAL( (xd * yd) % 256, 42u );
+  // a GraphSolver_Context only hands asserted expressions to its solver
+  // and reads the others as X
+  if ( evaluates_eagerly<ContextType>::value ) {
+    BOOST_CHECK_EQUAL( sumd, (xd + yd) % 256 );
+  } else {
+    vector<boost::logic::tribool> sumv = read_value( ctx, sum );
+    BOOST_CHECK( boost::logic::indeterminate( sumv.front() ) );
+  }
+
+  // the adder is encoded once it is used
+  assertion( ctx, metaSMT::logic::equal( sum, bvuint(13, w) ) );
+  BOOST_REQUIRE( solve(ctx) );
+  xd = read_value( ctx, x );
+  yd = read_value( ctx, y );
+  BOOST_CHECK_EQUAL( (xd + yd) % 256, 13u );
+  BOOST_CHECK_EQUAL( (xd * yd) % 256, 42u );
+}
+
+BOOST_AUTO_TEST_CASE( adder_encodings )
+{
+  const unsigned w = 12;
+
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  bitvector sum = new_bitvector(w);
+  bitvector diff = new_bitvector(w);
+  bitvector neg = new_bitvector(w);
+  predicate ult = new_variable();
+  predicate sle = new_variable();
+
+  set_option( ctx, "bitblast_adder", "ripple" );
+  assertion( ctx, equal( sum, bvadd(x, y) ) );
+  assertion( ctx, equal( diff, bvsub(x, y) ) );
+  assertion( ctx, equal( neg, bvneg(x) ) );
+  assertion( ctx, equal( ult, bvult(x, y) ) );
+  assertion( ctx, equal( sle, bvsle(x, y) ) );
+
+  const char * encodings[] = { "cla", "kogge-stone", "brent-kung" };
+  for (unsigned i = 0; i < 3; ++i) {
+    set_option( ctx, "bitblast_adder", encodings[i] );
+    assumption( ctx, Or( Or( nequal( sum, bvadd(x, y) ), nequal( diff, bvsub(x, y) ) )
+      , Or( nequal( neg, bvneg(x) ), Or( nequal( ult, bvult(x, y) ), nequal( sle, bvsle(x, y) ) ) ) ) );
+    BOOST_CHECK_MESSAGE( !solve(ctx), encodings[i] );
+  }
+}
+
 BOOST_AUTO_TEST_CASE( bvudiv_t )
 {
   using namespace boost::logic;
@@ -950,6 +1100,58 @@ BOOST_AUTO_TEST_CASE( bvsrem_t )
   BOOST_REQUIRE_EQUAL(zd, rd);
 }
 
+// SMT-LIB: x/0 = ~0, x%0 = x, signed division by zero
+// yields 1 for negative x and ~0 otherwise.
+BOOST_AUTO_TEST_CASE( div_by_zero )
+{
+  const unsigned w = 8;
+
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  bitvector ones = new_bitvector(w);
+
+  assertion( ctx, equal(y, bvuint(0, w)) );
+  assertion( ctx, equal(ones, bvuint(255, w)) );
+  BOOST_REQUIRE( solve(ctx) );
+
+  assumption( ctx, nequal(bvudiv(x, y), ones) );
+  BOOST_CHECK( !solve(ctx) );
+
+  assumption( ctx, nequal(bvurem(x, y), x) );
+  BOOST_CHECK( !solve(ctx) );
+
+  assumption( ctx, nequal(bvsdiv(x, y),
+    Ite( bvslt(x, bvuint(0, w)), bvuint(1, w), ones ) ) );
+  BOOST_CHECK( !solve(ctx) );
+
+  assumption( ctx, nequal(bvsrem(x, y), x) );
+  BOOST_CHECK( !solve(ctx) );
+}
+
+BOOST_AUTO_TEST_CASE( bvsrem_sign )
+{
+  const unsigned w = 8;
+
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  // the remainder takes the sign of the dividend
+  assumption( ctx, equal(x, bvsint(7, w)) );
+  assumption( ctx, equal(y, bvsint(-2, w)) );
+  assumption( ctx, nequal(bvsrem(x, y), bvsint(1, w)) );
+  BOOST_CHECK( !solve(ctx) );
+
+  assumption( ctx, equal(x, bvsint(-7, w)) );
+  assumption( ctx, equal(y, bvsint(2, w)) );
+  assumption( ctx, nequal(bvsrem(x, y), bvsint(-1, w)) );
+  BOOST_CHECK( !solve(ctx) );
+
+  assumption( ctx, equal(x, bvsint(-7, w)) );
+  assumption( ctx, equal(y, bvsint(-2, w)) );
+  assumption( ctx, nequal(bvsdiv(x, y), bvsint(3, w)) );
+  BOOST_CHECK( !solve(ctx) );
+}
+
 BOOST_AUTO_TEST_CASE( bvurem_2 )
 {
   using namespace boost::logic;
@@ -1692,6 +1894,61 @@ BOOST_AUTO_TEST_CASE( bvashr_t )
    BOOST_REQUIRE( !solve(ctx) );
 }
 
+BOOST_AUTO_TEST_CASE( bvshr_all )
+{
+  const unsigned w = 6;
+  const unsigned xd = 45;
+  bitvector y = new_bitvector(w);
+  bitvector z = new_bitvector(w);
+
+  BOOST_REQUIRE( solve(ctx) );
+  assertion(ctx, equal( z, bvshr( bvuint(xd,w), y)) );
+
+  // includes shift amounts >= w
+  for (unsigned yd = 0; yd < (1u << w); ++yd) {
+    assumption( ctx, equal(y, bvuint(yd,w)) );
+    BOOST_REQUIRE( solve(ctx) );
+    unsigned zd = read_value(ctx, z);
+    unsigned shifted = yd < w ? xd >> yd : 0;
+    BOOST_REQUIRE_EQUAL(shifted, zd);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( bvashr_all )
+{
+  const unsigned w = 6;
+  const unsigned xd = 45; // negative
+  bitvector y = new_bitvector(w);
+  bitvector z = new_bitvector(w);
+
+  BOOST_REQUIRE( solve(ctx) );
+  assertion(ctx, equal( z, bvashr( bvuint(xd,w), y)) );
+
+  // includes shift amounts >= w
+  for (unsigned yd = 0; yd < (1u << w); ++yd) {
+    assumption( ctx, equal(y, bvuint(yd,w)) );
+    BOOST_REQUIRE( solve(ctx) );
+    unsigned zd = read_value(ctx, z);
+    unsigned shifted = yd < w
+      ? ((xd >> yd) | (((1u << w) - 1) << (w - yd))) % (1u << w)
+      : (1u << w) - 1;
+    BOOST_REQUIRE_EQUAL(shifted, zd);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( bvshl_overflow )
+{
+  const unsigned w = 5;
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  BOOST_REQUIRE( solve(ctx) );
+  // shift amounts between 5 and 31 always yield 0
+  assertion( ctx, bvuge(y, bvuint(w,w)) );
+  assertion( ctx, nequal( bvshl(x, y), bvuint(0,w)) );
+  BOOST_REQUIRE( !solve(ctx) );
+}
+
 BOOST_AUTO_TEST_CASE( zero_extend_t )
 {
    const unsigned w = 8;
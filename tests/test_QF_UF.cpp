@@ -59,6 +59,44 @@ BOOST_AUTO_TEST_CASE( functional_consistency ) {
   BOOST_REQUIRE( solve(ctx) );
 }
 
+BOOST_AUTO_TEST_CASE( functional_consistency_unsat ) {
+  using namespace type;
+
+  unsigned const w = 8;
+  Uninterpreted_Function f = declare_function(BitVector(4))(BitVector(w));
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  assertion(ctx, equal(x, y) );
+  assertion(ctx, nequal(f(x), f(y)) );
+  BOOST_REQUIRE( !solve(ctx) );
+}
+
+BOOST_AUTO_TEST_CASE( many_applications ) {
+  using namespace type;
+
+  unsigned const w = 8;
+  unsigned const n = 40;
+  Uninterpreted_Function f = declare_function(BitVector(w))(BitVector(w));
+
+  std::vector<bitvector> x;
+  for (unsigned i = 0; i < n; ++i) {
+    x.push_back( new_bitvector(w) );
+    assertion(ctx, equal(f(x[i]), bvuint(i, w)) );
+  }
+  BOOST_REQUIRE( solve(ctx) );
+
+  // different results need different arguments
+  for (unsigned i = 1; i < n; ++i) {
+    unsigned x0 = read_value(ctx, x[0]);
+    unsigned xi = read_value(ctx, x[i]);
+    BOOST_CHECK_NE( x0, xi );
+  }
+
+  assumption(ctx, equal(x[0], x[n-1]) );
+  BOOST_REQUIRE( !solve(ctx) );
+}
+
 BOOST_AUTO_TEST_CASE( two_arguments ) {
   using namespace type;
   unsigned const w = 8;
@@ -7,6 +7,8 @@
 #include <metaSMT/DirectSolver_Context.hpp>
 #include <metaSMT/backend/SAT_Aiger.hpp>
 
+#include "count_clauses.hpp"
+
 //external includes
 #include <boost/array.hpp>
 #include <boost/proto/debug.hpp>
@@ -20,16 +22,24 @@ using namespace metaSMT;
 
 struct clause_printer
 {
-  void clause ( std::vector < SAT::tag::lit_tag > const& clause )
+  void add_clauses ( SAT::clause_span const& clauses )
   {
-    BOOST_FOREACH ( SAT::tag::lit_tag const& lit, clause )
-      std::cout << lit.id << " ";
-    std::cout << std::endl;
+    for ( SAT::tag::lit_tag const* it = clauses.first; it != clauses.last; ++it )
+    {
+      if ( it->id == 0 )
+      {
+        std::cout << std::endl;
+        ++clause_printer::clauses;
+      }
+      else
+        std::cout << it->id << " ";
+    }
   }
 
   void assertion ( SAT::tag::lit_tag const& lit ) 
   { 
     std::cout << "Assertion: " << lit.id << std::endl;
+    ++assertions;
   }
   void assumption ( SAT::tag::lit_tag const& lit ) 
   { 
@@ -41,8 +51,18 @@ struct clause_printer
     return false; 
   }
 
+  result_wrapper read_value ( SAT::tag::lit_tag const& lit )
+  {
+    return result_wrapper ( 'X' );
+  }
+
+  static unsigned assertions;
+  static unsigned clauses;
 };
 
+unsigned clause_printer::assertions = 0;
+unsigned clause_printer::clauses = 0;
+
 
 class aig_Fixture {
   public:
@@ -85,6 +105,116 @@ BOOST_AUTO_TEST_CASE( syntax )
 //   BOOST_REQUIRE_EQUAL(to_aiger( Not(Not(True)), aig )(), aiger_true);
 }
 
+BOOST_AUTO_TEST_CASE( structural_hashing )
+{
+  using namespace logic;
+  predicate x = new_variable (); 
+  predicate y = new_variable (); 
+  const unsigned xl = evaluate ( ctx, x );
+  const unsigned yl = evaluate ( ctx, y );
+
+  const unsigned xy = evaluate ( ctx, And ( x, y ) );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, And ( y, x ) ), xy );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, Nand ( x, y ) ), aiger_not ( xy ) );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, Xor ( x, y ) ), evaluate ( ctx, Xor ( x, y ) ) );
+
+  BOOST_CHECK_EQUAL( evaluate ( ctx, And ( x, x ) ), xl );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, And ( x, Not ( x ) ) ), aiger_false );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, And ( x, True ) ), xl );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, Or ( y, False ) ), yl );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, And ( x, And ( x, y ) ) ), xy );
+  BOOST_CHECK_EQUAL( evaluate ( ctx, And ( Not ( x ), And ( x, y ) ) ), aiger_false );
+}
+
+// assertions are forwarded to the SAT solver only once
+BOOST_AUTO_TEST_CASE( incremental_solve )
+{
+  using namespace logic;
+  predicate x = new_variable (); 
+  predicate y = new_variable (); 
+  assertion ( ctx, Or ( x, y ) ); 
+
+  clause_printer::assertions = 0;
+  solve ( ctx );
+  const unsigned first = clause_printer::assertions;
+  BOOST_CHECK_GT( first, 0u );
+
+  solve ( ctx );
+  BOOST_CHECK_EQUAL( clause_printer::assertions, first );
+
+  assertion ( ctx, x ); 
+  solve ( ctx );
+  BOOST_CHECK_EQUAL( clause_printer::assertions, first + 1 );
+}
+
+// fraig proves both sides of the miter equivalent
+BOOST_AUTO_TEST_CASE( optimize )
+{
+  using namespace logic;
+  set_option ( ctx, "aig_optimize", "balance,rewrite,fraig" );
+
+  predicate x = new_variable (); 
+  predicate y = new_variable (); 
+  predicate z = new_variable (); 
+  const unsigned lhs = evaluate ( ctx, And ( x, Or ( y, z ) ) );
+  const unsigned rhs = evaluate ( ctx, Or ( And ( x, y ), And ( x, z ) ) );
+  BOOST_REQUIRE_NE( lhs, rhs );
+  assertion ( ctx, Xor ( And ( x, Or ( y, z ) ), Or ( And ( x, y ), And ( x, z ) ) ) ); 
+
+  solve ( ctx );
+  AigStatistics stats = aig_statistics ( ctx );
+  BOOST_CHECK_GT( stats.before, 0u );
+  BOOST_CHECK_GT( stats.merged, 0u );
+  // the miter is constant false, no gate remains
+  BOOST_CHECK_EQUAL( stats.after, 0u );
+}
+
+// a random pattern satisfies the assertions, the SAT solver is not called
+BOOST_AUTO_TEST_CASE( simulate )
+{
+  using namespace logic;
+  set_option ( ctx, "aig_simulate", "1" );
+
+  predicate x = new_variable (); 
+  predicate y = new_variable (); 
+  predicate z = new_variable (); 
+  assertion ( ctx, Or ( And ( x, y ), z ) ); 
+  assumption ( ctx, Not ( x ) ); 
+
+  clause_printer::assertions = 0;
+  // clause_printer::solve is always false
+  BOOST_REQUIRE( solve ( ctx ) );
+  BOOST_CHECK_EQUAL( clause_printer::assertions, 0u );
+  BOOST_CHECK_EQUAL( aig_statistics ( ctx ).simulated, 1u );
+  BOOST_CHECK( !read_value ( ctx, x ) );
+  BOOST_CHECK( read_value ( ctx, z ) );
+
+  assertion ( ctx, Not ( z ) ); 
+  assertion ( ctx, Not ( x ) ); 
+  BOOST_CHECK( !solve ( ctx ) );
+  BOOST_CHECK_GT( clause_printer::assertions, 0u );
+}
+
+/**
+ * the parity of four variables asserted
+ **/
+void parity ( DirectSolver_Context < SAT_Aiger < clause_printer > > & ctx, unsigned )
+{
+  using namespace logic;
+  predicate a = new_variable (); 
+  predicate b = new_variable (); 
+  predicate c = new_variable (); 
+  predicate d = new_variable (); 
+  assertion ( ctx, Xor ( Xor ( a, b ), Xor ( c, d ) ) ); 
+}
+
+// two xor cuts (3 and 2 inputs) cover the nine and gates of the parity
+BOOST_AUTO_TEST_CASE( cut_cnf )
+{
+  BOOST_CHECK_EQUAL( count_clauses<clause_printer> ( "aig_cnf", "gates", parity, 0 ), 27u );
+  BOOST_CHECK_EQUAL( count_clauses<clause_printer> ( "aig_cnf", "cuts", parity, 0 ), 8u + 4u );
+}
+
 BOOST_AUTO_TEST_SUITE_END() //QF_BV
 
 //  vim: ft=cpp:ts=2:sw=2:expandtab
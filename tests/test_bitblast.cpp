@@ -0,0 +1,467 @@
+#define BOOST_TEST_MODULE test_bitblast
+#include <boost/test/unit_test.hpp>
+
+//internal includes
+#include <metaSMT/frontend/QF_BV.hpp>
+#include <metaSMT/frontend/Array.hpp>
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/backend/SAT_Clause.hpp>
+#include <metaSMT/BitBlast.hpp>
+#include <metaSMT/API/Options.hpp>
+#include <metaSMT/support/BitVectorView.hpp>
+
+#include "count_clauses.hpp"
+
+//external includes
+#include <boost/foreach.hpp>
+
+#include <set>
+
+using namespace metaSMT;
+using namespace metaSMT::logic;
+using namespace metaSMT::logic::QF_BV;
+using namespace metaSMT::logic::Array;
+
+/**
+ * SAT backend that does not solve anything but records the size of the
+ * generated CNF. Used to check the size of the BitBlast encodings.
+ **/
+struct clause_counter
+{
+  void add_clauses ( SAT::clause_span const& cls )
+  {
+    for ( SAT::tag::lit_tag const* it = cls.first; it != cls.last; ++it ) {
+      if ( it->id == 0 )
+        ++clauses;
+      else
+        variables.insert( it->var() );
+    }
+  }
+
+  void assertion ( SAT::tag::lit_tag const& lit ) { }
+  void assumption ( SAT::tag::lit_tag const& lit ) { }
+  bool solve () { return false; }
+
+  result_wrapper read_value ( SAT::tag::lit_tag const& lit ) {
+    return result_wrapper('X');
+  }
+
+  static unsigned clauses;
+  static std::set<int> variables;
+};
+
+unsigned clause_counter::clauses = 0;
+std::set<int> clause_counter::variables;
+
+typedef DirectSolver_Context < BitBlast < SAT_Clause < clause_counter > > > ContextType;
+
+class BitBlast_Fixture {
+  public:
+    BitBlast_Fixture() {
+      clause_counter::clauses = 0;
+      clause_counter::variables.clear();
+    }
+
+  protected:
+    // solve hands the clauses buffered in SAT_Clause to the clause_counter
+    unsigned clauses() { solve( ctx ); return clause_counter::clauses; }
+    unsigned variables() { solve( ctx ); return clause_counter::variables.size(); }
+
+    ContextType ctx;
+};
+
+/**
+ * a w bit multiplier
+ **/
+void multiply( ContextType & ctx, unsigned w ) {
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  evaluate( ctx, bvmul(x, y) );
+}
+
+/**
+ * a w bit adder
+ **/
+void add( ContextType & ctx, unsigned w ) {
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  evaluate( ctx, bvadd(x, y) );
+}
+
+BOOST_FIXTURE_TEST_SUITE(bitblast_t, BitBlast_Fixture )
+
+// the barrel shifter needs one row of w multiplexers per bit of the
+// shift amount below log2(w) plus one row for the overflow.
+// The previous encoding compared the shift amount with every
+// possible value and needed about 45000 clauses for w = 64.
+BOOST_AUTO_TEST_CASE( bvshl_size )
+{
+  const unsigned w = 64;
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  evaluate( ctx, bvshl(x, y) );
+  BOOST_CHECK_LT( clauses(), 4*w*8 );
+  BOOST_CHECK_LT( variables(), w*10 );
+}
+
+BOOST_AUTO_TEST_CASE( bvshr_size )
+{
+  const unsigned w = 64;
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  evaluate( ctx, bvshr(x, y) );
+  BOOST_CHECK_LT( clauses(), 4*w*8 );
+  BOOST_CHECK_LT( variables(), w*10 );
+}
+
+BOOST_AUTO_TEST_CASE( bvashr_size )
+{
+  const unsigned w = 64;
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  evaluate( ctx, bvashr(x, y) );
+  BOOST_CHECK_LT( clauses(), 4*w*8 );
+  BOOST_CHECK_LT( variables(), w*10 );
+}
+
+BOOST_AUTO_TEST_CASE( gate_cache_disabled_by_default )
+{
+  bitvector x = new_bitvector(8);
+  bitvector y = new_bitvector(8);
+
+  evaluate( ctx, bvand(x, y) );
+  evaluate( ctx, bvand(x, y) );
+  BOOST_CHECK_EQUAL( clauses(), 2*8u*3 );
+  BOOST_CHECK_EQUAL( gate_cache_statistics(ctx).hits, 0u );
+}
+
+BOOST_AUTO_TEST_CASE( gate_cache_idempotent )
+{
+  set_option( ctx, "bitblast_gate_cache", "1" );
+  bitvector x = new_bitvector(8);
+
+  evaluate( ctx, bvand(x, x) );
+  evaluate( ctx, bvor(x, x) );
+  evaluate( ctx, bvxor(x, x) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( gate_cache_complement )
+{
+  set_option( ctx, "bitblast_gate_cache", "1" );
+  bitvector x = new_bitvector(8);
+
+  evaluate( ctx, bvand(x, bvnot(x)) );
+  evaluate( ctx, bvor(x, bvnot(x)) );
+  // only the constants are encoded
+  BOOST_CHECK_LE( clauses(), 2u );
+}
+
+BOOST_AUTO_TEST_CASE( gate_cache_shared_gates )
+{
+  set_option( ctx, "bitblast_gate_cache", "1" );
+  const unsigned w = 16;
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  evaluate( ctx, bvadd(x, y) );
+  const unsigned first = clauses();
+  evaluate( ctx, bvadd(y, x) );
+  BOOST_CHECK_EQUAL( clauses(), first );
+
+  GateCacheStatistics stats = gate_cache_statistics(ctx);
+  BOOST_CHECK_GT( stats.hits, 0u );
+  BOOST_CHECK_GT( stats.hit_rate(), 0.0 );
+}
+
+// constant bits are propagated through all operators,
+// with or without the gate cache.
+BOOST_AUTO_TEST_CASE( constant_mask )
+{
+  bitvector x = new_bitvector(16);
+
+  evaluate( ctx, bvand(x, bvuint(0xFF00, 16)) );
+  evaluate( ctx, bvor(x, bvuint(0, 16)) );
+  evaluate( ctx, bvxor(x, bvuint(0, 16)) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( constant_add_zero )
+{
+  bitvector x = new_bitvector(16);
+
+  evaluate( ctx, bvadd(x, bvuint(0, 16)) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( constant_shift )
+{
+  bitvector x = new_bitvector(32);
+
+  evaluate( ctx, bvshl(x, bvuint(5, 32)) );
+  evaluate( ctx, bvashr(x, bvuint(7, 32)) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( constant_mul_power_of_two )
+{
+  bitvector x = new_bitvector(16);
+
+  evaluate( ctx, bvmul(x, bvuint(8, 16)) );
+  evaluate( ctx, bvmul(bvuint(1, 16), x) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( constant_compare )
+{
+  bitvector x = new_bitvector(16);
+
+  evaluate( ctx, bvult(x, bvuint(0, 16)) );
+  evaluate( ctx, bvuge(x, bvuint(0, 16)) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( multiplier_size )
+{
+  const unsigned w = 32;
+  const unsigned array = count_clauses<clause_counter>("bitblast_multiplier", "array", multiply, w);
+
+  BOOST_CHECK_LT( count_clauses<clause_counter>("bitblast_multiplier", "wallace", multiply, w), array );
+  BOOST_CHECK_LT( count_clauses<clause_counter>("bitblast_multiplier", "dadda", multiply, w), array );
+  BOOST_CHECK_LT( count_clauses<clause_counter>("bitblast_multiplier", "booth", multiply, w), array );
+}
+
+BOOST_AUTO_TEST_CASE( unknown_multiplier )
+{
+  BOOST_CHECK_THROW( set_option( ctx, "bitblast_multiplier", "karatsuba" )
+                   , std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( unknown_adder )
+{
+  BOOST_CHECK_THROW( set_option( ctx, "bitblast_adder", "carry-select" )
+                   , std::invalid_argument );
+}
+
+// the parallel prefix adders trade size for depth:
+// Brent-Kung needs about 2w cells, Kogge-Stone about w*log2(w)
+BOOST_AUTO_TEST_CASE( adder_size )
+{
+  const unsigned w = 64;
+  const unsigned ripple = count_clauses<clause_counter>("bitblast_adder", "ripple", add, w);
+  const unsigned brent_kung = count_clauses<clause_counter>("bitblast_adder", "brent-kung", add, w);
+
+  BOOST_CHECK_LT( ripple, count_clauses<clause_counter>("bitblast_adder", "cla", add, w) );
+  BOOST_CHECK_LT( ripple, brent_kung );
+  BOOST_CHECK_LT( brent_kung, count_clauses<clause_counter>("bitblast_adder", "kogge-stone", add, w) );
+}
+
+BOOST_AUTO_TEST_CASE( adder_constants )
+{
+  const char * adders[] = { "ripple", "cla", "kogge-stone", "brent-kung" };
+  for (unsigned i = 0; i < 4; ++i) {
+    set_option( ctx, "bitblast_adder", adders[i] );
+    bitvector x = new_bitvector(16);
+
+    evaluate( ctx, bvadd(x, bvuint(0, 16)) );
+    evaluate( ctx, bvsub(x, bvuint(0, 16)) );
+    evaluate( ctx, bvult(x, bvuint(0, 16)) );
+    evaluate( ctx, bvuge(x, bvuint(0, 16)) );
+    BOOST_CHECK_MESSAGE( clauses() == 0, adders[i] );
+  }
+}
+
+// lazy multipliers and dividers are only encoded by a few lemmas
+// until a model violates them
+BOOST_AUTO_TEST_CASE( lazy_arithmetic_size )
+{
+  const unsigned w = 32;
+  const unsigned array = count_clauses<clause_counter>("bitblast_multiplier", "array", multiply, w);
+
+  clause_counter::clauses = 0;
+  set_option( ctx, "bitblast_lazy_arithmetic", "1" );
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  evaluate( ctx, bvmul(x, y) );
+  evaluate( ctx, bvudiv(x, y) );
+  evaluate( ctx, bvsrem(x, y) );
+  BOOST_CHECK_LT( clauses(), array/10 );
+}
+
+// quotient and remainder of the same operands share one divider
+BOOST_AUTO_TEST_CASE( divider_shared )
+{
+  const unsigned w = 16;
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+
+  evaluate( ctx, bvudiv(x, y) );
+  const unsigned udiv = clauses();
+  evaluate( ctx, bvurem(x, y) );
+  BOOST_CHECK_EQUAL( clauses(), udiv );
+
+  evaluate( ctx, bvsdiv(x, y) );
+  const unsigned sdiv = clauses();
+  evaluate( ctx, bvsrem(x, y) );
+  BOOST_CHECK_EQUAL( clauses(), sdiv );
+}
+
+/**
+ * three reads of an array with index width w
+ **/
+void read_three( ContextType & ctx, unsigned w ) {
+  array a = new_array(8, w);
+  for (unsigned i = 0; i < 3; ++i) {
+    evaluate( ctx, select(a, new_bitvector(w)) );
+  }
+}
+
+// arrays with small indices get all read lemmas when the reads are
+// encoded, larger ones only get them on demand while solving
+BOOST_AUTO_TEST_CASE( array_read_lemmas )
+{
+  BOOST_CHECK_EQUAL( count_clauses<clause_counter>("bitblast_array_eager_width", "0", read_three, 4), 0u );
+  BOOST_CHECK_GT( count_clauses<clause_counter>("bitblast_array_eager_width", "4", read_three, 4), 0u );
+  BOOST_CHECK_EQUAL( count_clauses<clause_counter>("bitblast_array_eager_width", "4", read_three, 5), 0u );
+}
+
+// a read of a stored index needs no read of the base array
+BOOST_AUTO_TEST_CASE( array_read_over_write )
+{
+  set_option( ctx, "bitblast_array_eager_width", "4" );
+  array a = new_array(8, 4);
+  bitvector i = new_bitvector(4);
+
+  evaluate( ctx, select(a, new_bitvector(4)) );
+  evaluate( ctx, select(store(a, i, bvuint(42, 8)), i) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+}
+
+/**
+ * x <= y asserted on w bits, x + y evaluated but unused
+ **/
+void sum_and_ule( ContextType & ctx, unsigned w ) {
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  evaluate( ctx, bvadd(x, y) );
+  assertion( ctx, bvule(x, y) );
+}
+
+// polarity aware encoding skips unused gates and the unused
+// direction of the others
+BOOST_AUTO_TEST_CASE( polarity_encoding )
+{
+  set_option( ctx, "sat_clause_polarity", "1" );
+  bitvector x = new_bitvector(16);
+  bitvector y = new_bitvector(16);
+  evaluate( ctx, bvadd(x, y) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+
+  BOOST_CHECK_LT( count_clauses<clause_counter>("sat_clause_polarity", "1", sum_and_ule, 16)
+                , count_clauses<clause_counter>("sat_clause_polarity", "0", sum_and_ule, 16) );
+}
+
+/**
+ * And(a, Not(p)) asserted after the polarity and lazy modes are turned
+ * off, where a = And(p, q) is created before
+ **/
+void switch_off( ContextType & ctx, unsigned ) {
+  predicate p = new_variable();
+  predicate q = new_variable();
+  ContextType::result_type a = evaluate( ctx, And(p, q) );
+  set_option( ctx, "sat_clause_polarity", "0" );
+  set_option( ctx, "sat_clause_lazy", "0" );
+  assertion( ctx, And(a, Not(p)) );
+}
+
+// a deferred gate gets its full definition once an eagerly encoded
+// gate uses it
+BOOST_AUTO_TEST_CASE( polarity_switch_off )
+{
+  BOOST_CHECK_EQUAL( count_clauses<clause_counter>("sat_clause_polarity", "1", switch_off, 0)
+                   , count_clauses<clause_counter>("sat_clause_polarity", "0", switch_off, 0) );
+}
+
+/**
+ * x*y == 1 asserted on w bits, x + y evaluated but unused
+ **/
+void sum_and_product( ContextType & ctx, unsigned w ) {
+  bitvector x = new_bitvector(w);
+  bitvector y = new_bitvector(w);
+  evaluate( ctx, bvadd(x, y) );
+  assertion( ctx, equal( bvmul(x, y), bvuint(1, w) ) );
+}
+
+// the lazy mode only encodes the gates reachable from the assertions
+BOOST_AUTO_TEST_CASE( cone_of_influence )
+{
+  set_option( ctx, "sat_clause_lazy", "1" );
+  bitvector x = new_bitvector(16);
+  bitvector y = new_bitvector(16);
+  evaluate( ctx, bvadd(x, y) );
+  BOOST_CHECK_EQUAL( clauses(), 0u );
+
+  // unused carries of the multiplier are skipped as well
+  BOOST_CHECK_LT( count_clauses<clause_counter>("sat_clause_lazy", "1", sum_and_product, 8)
+                + count_clauses<clause_counter>("bitblast_adder", "ripple", add, 8)
+                , count_clauses<clause_counter>("sat_clause_lazy", "0", sum_and_product, 8) );
+}
+
+// the same for gates deferred by the lazy mode
+BOOST_AUTO_TEST_CASE( lazy_switch_off )
+{
+  BOOST_CHECK_EQUAL( count_clauses<clause_counter>("sat_clause_lazy", "1", switch_off, 0)
+                   , count_clauses<clause_counter>("sat_clause_lazy", "0", switch_off, 0) );
+}
+
+// each context numbers its SAT variables densely from 1
+BOOST_AUTO_TEST_CASE( dense_variables )
+{
+  bitvector x = new_bitvector(8);
+  bitvector y = new_bitvector(8);
+
+  evaluate( ctx, bvadd(x, y) );
+  solve( ctx );
+  std::set<int> first = clause_counter::variables;
+  BOOST_REQUIRE( !first.empty() );
+  BOOST_CHECK_LE( unsigned(*first.rbegin()), first.size() + 1 );
+
+  clause_counter::variables.clear();
+  ContextType other;
+  evaluate( other, bvadd(x, y) );
+  solve( other );
+  BOOST_CHECK( clause_counter::variables == first );
+}
+
+BOOST_AUTO_TEST_CASE( bitvector_view )
+{
+  typedef BitVectorView<int> view;
+  view v(8);
+  for (unsigned i = 0; i < 8; ++i) {
+    v[i] = i;
+  }
+
+  view lo = v.slice(0, 4);
+  view hi = v.slice(4, 4);
+  BOOST_CHECK_EQUAL( hi[0], 4 );
+  // adjacent slices are merged without a new node
+  BOOST_CHECK( view::concat(lo, hi) == v );
+
+  view swapped = view::concat(hi, lo);
+  BOOST_CHECK_EQUAL( swapped.size(), 8u );
+  BOOST_CHECK_EQUAL( swapped[0], 4 );
+  BOOST_CHECK_EQUAL( swapped[7], 3 );
+
+  // writes to a shared view copy it first
+  lo[0] = 42;
+  BOOST_CHECK_EQUAL( v[0], 0 );
+  BOOST_CHECK_EQUAL( swapped[4], 0 );
+  BOOST_CHECK_EQUAL( lo[0], 42 );
+}
+
+BOOST_AUTO_TEST_SUITE_END() //bitblast_t
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
@@ -113,6 +113,61 @@ BOOST_AUTO_TEST_CASE( syntax )
 
 }
 
+// equal expressions are evaluated to the same node
+BOOST_AUTO_TEST_CASE( unique_nodes )
+{
+  bitvector x = new_bitvector(8);
+  bitvector y = new_bitvector(8);
+  predicate p = new_variable();
+  predicate q = new_variable();
+  predicate r = new_variable();
+
+  SMT_Expression e = evaluate( ctx, bvadd(x, y) );
+  BOOST_CHECK_EQUAL( evaluate(ctx, bvadd(y, x)), e );
+  BOOST_CHECK_NE( evaluate(ctx, bvsub(x, y)), evaluate(ctx, bvsub(y, x)) );
+  BOOST_CHECK_EQUAL( evaluate(ctx, extract(3, 0, x)), evaluate(ctx, extract(3, 0, x)) );
+  BOOST_CHECK_NE( evaluate(ctx, extract(3, 0, x)), evaluate(ctx, extract(4, 1, x)) );
+  BOOST_CHECK_EQUAL( evaluate(ctx, bvuint(42, 8)), evaluate(ctx, bvuint(42, 8)) );
+
+  // and/or chains are flattened
+  e = evaluate( ctx, And(p, And(q, r)) );
+  BOOST_CHECK_EQUAL( evaluate(ctx, And(And(r, q), p)), e );
+  BOOST_CHECK_EQUAL( evaluate(ctx, And(And(p, r), And(q, p))), e );
+  BOOST_CHECK_EQUAL( evaluate(ctx, And(p, p)), evaluate(ctx, p) );
+  BOOST_CHECK_NE( evaluate(ctx, Or(p, And(q, r))), e );
+
+  // Or(r, q) and the chain Or(Or(p, q), r), the second chain is shared
+  const std::size_t nodes = ctx.graph().size();
+  evaluate( ctx, Or(Or(r, q), p) );
+  evaluate( ctx, Or(p, Or(q, r)) );
+  BOOST_CHECK_EQUAL( ctx.graph().size(), nodes + 3 );
+}
+
+// unreachable nodes are removed, the roots stay valid
+BOOST_AUTO_TEST_CASE( collect_garbage )
+{
+  bitvector x = new_bitvector(8);
+  bitvector y = new_bitvector(8);
+  predicate p = new_variable();
+
+  vector<SMT_Expression> roots;
+  roots.push_back( evaluate(ctx, And(p, equal(bvadd(x, y), bvuint(3, 8)))) );
+  const std::size_t nodes = ctx.graph().size();
+  for ( unsigned i = 0; i < 100; ++i ) {
+    evaluate( ctx, bvmul(bvsub(x, bvuint(i, 8)), y) );
+  }
+  BOOST_REQUIRE_GT( ctx.graph().size(), nodes );
+
+  BOOST_CHECK_GT( metaSMT::collect_garbage(ctx, roots), 0u );
+  BOOST_CHECK_EQUAL( ctx.graph().size(), nodes );
+  BOOST_CHECK_EQUAL( evaluate(ctx, And(equal(bvuint(3, 8), bvadd(y, x)), p)), roots[0] );
+  BOOST_CHECK_EQUAL( ctx.graph().size(), nodes );
+
+  roots.clear();
+  metaSMT::collect_garbage(ctx, roots);
+  BOOST_CHECK_EQUAL( ctx.graph().size(), 0u );
+}
+
 BOOST_AUTO_TEST_SUITE_END() //QF_BV
 
 //  vim: ft=cpp:ts=2:sw=2:expandtab
@@ -0,0 +1,140 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+
+#include <metaSMT/frontend/Logic.hpp>
+#include <metaSMT/frontend/QF_BV.hpp>
+#include <metaSMT/API/Options.hpp>
+
+using namespace std;
+using namespace metaSMT;
+using namespace metaSMT::solver;
+using namespace metaSMT::logic;
+using namespace metaSMT::logic::QF_BV;
+
+BOOST_FIXTURE_TEST_SUITE(graph_components, Solver_Fixture )
+
+BOOST_AUTO_TEST_CASE( components_sat )
+{
+  set_option( ctx, "graph_components", "1" );
+  bitvector x = new_bitvector(8);
+  bitvector y = new_bitvector(8);
+  bitvector z = new_bitvector(8);
+  predicate p = new_variable();
+
+  assertion( ctx, equal(x, bvuint(5, 8)) );
+  assertion( ctx, equal(bvadd(y, z), bvuint(9, 8)) );
+  assertion( ctx, equal(z, bvuint(2, 8)) );
+  assumption( ctx, p );
+
+  BOOST_REQUIRE( solve(ctx) );
+  unsigned xd = read_value(ctx, x);
+  unsigned yd = read_value(ctx, y);
+  unsigned zd = read_value(ctx, z);
+  BOOST_CHECK_EQUAL( xd, 5u );
+  BOOST_CHECK_EQUAL( yd, 7u );
+  BOOST_CHECK_EQUAL( zd, 2u );
+  BOOST_CHECK( read_value(ctx, p) );
+}
+
+BOOST_AUTO_TEST_CASE( components_unsat )
+{
+  set_option( ctx, "graph_components", "1" );
+  bitvector x = new_bitvector(8);
+  predicate p = new_variable();
+
+  assertion( ctx, equal(x, bvuint(3, 8)) );
+  assertion( ctx, p );
+  assumption( ctx, Not(p) );
+
+  BOOST_REQUIRE( !solve(ctx) );
+  BOOST_REQUIRE( solve(ctx) );
+  unsigned xd = read_value(ctx, x);
+  BOOST_CHECK_EQUAL( xd, 3u );
+
+  assertion( ctx, False );
+  BOOST_REQUIRE( !solve(ctx) );
+}
+
+BOOST_AUTO_TEST_CASE( components_shared )
+{
+  set_option( ctx, "graph_components", "1" );
+  predicate p = new_variable();
+  predicate q = new_variable();
+
+  assertion( ctx, Xor(p, q) );
+  assertion( ctx, p );
+  BOOST_REQUIRE( solve(ctx) );
+  BOOST_CHECK( !read_value(ctx, q) );
+
+  BOOST_REQUIRE( solve(ctx) );
+  assumption( ctx, q );
+  BOOST_REQUIRE( !solve(ctx) );
+}
+
+BOOST_AUTO_TEST_CASE( components_merge )
+{
+  set_option( ctx, "graph_components", "1" );
+  bitvector x = new_bitvector(8);
+  bitvector y = new_bitvector(8);
+
+  assertion( ctx, equal(x, bvuint(5, 8)) );
+  assertion( ctx, equal(y, bvuint(7, 8)) );
+  BOOST_REQUIRE( solve(ctx) );
+
+  assertion( ctx, bvult(x, y) );
+  BOOST_REQUIRE( solve(ctx) );
+  unsigned xd = read_value(ctx, x);
+  unsigned yd = read_value(ctx, y);
+  BOOST_CHECK_EQUAL( xd, 5u );
+  BOOST_CHECK_EQUAL( yd, 7u );
+
+  assumption( ctx, equal(x, y) );
+  BOOST_REQUIRE( !solve(ctx) );
+  BOOST_REQUIRE( solve(ctx) );
+}
+
+BOOST_AUTO_TEST_CASE( components_incremental )
+{
+  set_option( ctx, "graph_components", "1" );
+  std::vector<bitvector> xs;
+  for ( unsigned i = 0; i < 8; ++i ) {
+    xs.push_back( new_bitvector(8) );
+    assertion( ctx, bvuge(xs[i], bvuint(i, 8)) );
+  }
+  BOOST_REQUIRE( solve(ctx) );
+
+  for ( unsigned i = 0; i < 8; ++i ) {
+    assertion( ctx, bvule(xs[i], bvuint(i, 8)) );
+    BOOST_REQUIRE( solve(ctx) );
+    unsigned xd = read_value(ctx, xs[i]);
+    BOOST_CHECK_EQUAL( xd, i );
+  }
+
+  assumption( ctx, equal(xs[3], bvuint(4, 8)) );
+  BOOST_REQUIRE( !solve(ctx) );
+  BOOST_REQUIRE( solve(ctx) );
+  for ( unsigned i = 0; i < 8; ++i ) {
+    unsigned xd = read_value(ctx, xs[i]);
+    BOOST_CHECK_EQUAL( xd, i );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( components_off )
+{
+  set_option( ctx, "graph_components", "1" );
+  predicate p = new_variable();
+  predicate q = new_variable();
+
+  assertion( ctx, p );
+  assertion( ctx, q );
+  BOOST_REQUIRE( solve(ctx) );
+
+  set_option( ctx, "graph_components", "0" );
+  assertion( ctx, Or(Not(p), Not(q)) );
+  BOOST_REQUIRE( !solve(ctx) );
+}
+
+BOOST_AUTO_TEST_SUITE_END() //graph_components
+
+//  vim: ft=cpp:ts=2:sw=2:expandtab
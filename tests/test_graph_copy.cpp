@@ -62,6 +62,31 @@ BOOST_AUTO_TEST_CASE( copy_assume )
   BOOST_REQUIRE( solve(ctx2) );
 }
 
+BOOST_AUTO_TEST_CASE( copies_diverge )
+{
+  predicate p = new_variable();
+  predicate q = new_variable();
+
+  assertion( ctx, Xor(p, q) );
+  BOOST_REQUIRE( solve(ctx) );
+
+  ContextType ctx2(ctx);
+  ContextType ctx3(ctx2);
+
+  assertion( ctx2, p );
+  assertion( ctx3, q );
+
+  BOOST_REQUIRE( solve(ctx2) );
+  BOOST_CHECK( !read_value(ctx2, q) );
+  BOOST_REQUIRE( solve(ctx3) );
+  BOOST_CHECK( !read_value(ctx3, p) );
+
+  assertion( ctx3, p );
+  BOOST_REQUIRE( !solve(ctx3) );
+  BOOST_REQUIRE( solve(ctx2) );
+  BOOST_REQUIRE( solve(ctx) );
+}
+
 BOOST_AUTO_TEST_SUITE_END() //Solver
 
 //  vim: ft=cpp:ts=2:sw=2:expandtab
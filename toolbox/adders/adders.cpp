@@ -0,0 +1,111 @@
+#include <metaSMT/frontend/QF_BV.hpp>
+#include <metaSMT/DirectSolver_Context.hpp>
+#include <metaSMT/backend/CUDD_Context.hpp>
+#include <metaSMT/backend/SAT_Aiger.hpp>
+#include <metaSMT/backend/MiniSAT.hpp>
+#include <metaSMT/BitBlast.hpp>
+#include <metaSMT/support/run_algorithm.hpp>
+
+#include <boost/mpl/vector.hpp>
+#include <boost/format.hpp>
+#include <boost/timer.hpp>
+
+#include <iostream>
+
+using namespace metaSMT;
+using namespace metaSMT::logic;
+using namespace metaSMT::logic::QF_BV;
+using namespace metaSMT::solver;
+using namespace std;
+
+/**
+ * compares the BitBlast adder encodings: proves some identities of
+ * addition, subtraction and comparison and solves a few sums.
+ **/
+template<typename Solver>
+struct my_algo
+{
+  typedef int result_type;
+
+  my_algo ( unsigned width, std::string adder ) :
+    width_ (width)
+  {
+    set_option( ctx, "bitblast_adder", adder );
+  };
+
+  result_type operator()()
+  {
+    const unsigned width = width_;
+
+    bitvector x = new_bitvector(width);
+    bitvector y = new_bitvector(width);
+    bitvector z = new_bitvector(width);
+
+    boost::timer timer;
+    int valids = 0;
+
+    // (x + y) - y == x
+    assumption( ctx, nequal( bvsub( bvadd(x, y), y ), x ) );
+    if ( !solve(ctx) ) ++valids;
+
+    // x < y <=> -x - 1 > -y - 1
+    assumption( ctx, nequal( bvult(x, y)
+      , bvugt( bvsub( bvneg(x), bvuint(1, width) ), bvsub( bvneg(y), bvuint(1, width) ) ) ) );
+    if ( !solve(ctx) ) ++valids;
+
+    std::cout << boost::format("identities proved in %.2fs") % timer.elapsed() << std::endl;
+
+    for (unsigned i = 0; i < 10; i++)
+    {
+      unsigned r = (unsigned long long)rand()%(1ull<<width);
+      assumption( ctx, equal( bvadd( bvadd(x, y), z ), bvuint(r, width) ) );
+      assumption( ctx, bvult(x, y) );
+      assumption( ctx, bvslt(y, z) );
+
+      if( solve( ctx) ) {
+        unsigned x_value = read_value ( ctx, x );
+        unsigned y_value = read_value ( ctx, y );
+        unsigned z_value = read_value ( ctx, z );
+
+        std::cout << r << " = " << x_value << " + " << y_value << " + " << z_value << std::endl;
+        valids++;
+      } else {
+        std::cout << boost::format("no sum for %u") % r << std::endl;
+      }
+    }
+
+    std::cout << boost::format("total time %.2fs") % timer.elapsed() << std::endl;
+
+    return valids;
+  }
+
+  Solver ctx;
+  unsigned width_;
+};
+
+
+int main(int argc, const char *argv[])
+{
+  typedef mpl::vector2 <
+    DirectSolver_Context< BitBlast < CUDD_Context > >
+  , DirectSolver_Context< BitBlast < SAT_Aiger < MiniSAT > > >
+  > SolverVec;
+
+  if( argc < 3) {
+    cout << "usage: adders solver width [adder]\n"
+            "solver:\n\t0 - CUDD (BitBlast)\n\t1 - MiniSAT (BitBlast, Aiger)\n"
+            "adder:\n\tripple (default), cla, kogge-stone, brent-kung"
+         << endl;
+    exit(1);
+  }
+
+  unsigned solver = atoi ( argv[1] );
+  unsigned width  = atoi ( argv[2] );
+  std::string adder = argc > 3 ? argv[3] : "ripple";
+
+  int val = run_algorithm<SolverVec, my_algo> ( solver, width, adder );
+
+  cout << "Got " << val << endl;
+
+  return 0;
+}
@@ -1,6 +1,11 @@
 #include <metaSMT/backend/Boolector.hpp>
 #include <metaSMT/DirectSolver_Context.hpp>
 #include <metaSMT/frontend/QF_BV.hpp>
+#ifdef WITH_MINISAT
+#include <metaSMT/backend/SAT_Clause.hpp>
+#include <metaSMT/backend/MiniSAT.hpp>
+#include <metaSMT/BitBlast.hpp>
+#endif
 
 #include <boost/timer.hpp>
 #include <iostream>
@@ -14,13 +19,25 @@ static unsigned data[limit];
 
 static unsigned all_valids = 0;
 
+// multiplier encoding used by the BitBlast contexts
+static std::string multiplier = "array";
+
+typedef metaSMT::DirectSolver_Context<metaSMT::solver::Boolector> BoolectorContext;
+#ifdef WITH_MINISAT
+typedef metaSMT::DirectSolver_Context<
+  metaSMT::BitBlast< metaSMT::SAT_Clause< metaSMT::solver::MiniSAT > >
+> MiniSATContext;
+#endif
+
+template <typename Context>
 int run_metaSMT () {
   using namespace metaSMT;
   using namespace metaSMT::logic;
   using namespace metaSMT::logic::QF_BV;
 
 
-  metaSMT::DirectSolver_Context<metaSMT::solver::Boolector> ctx;
+  Context ctx;
+  set_option( ctx, "bitblast_multiplier", multiplier );
 
   bitvector a = new_bitvector(width);
   bitvector b = new_bitvector(width);
@@ -104,10 +121,18 @@ void result( std::string const & name, double time) {
 
 int main(int argc, const char *argv[])
 {
+#ifdef WITH_MINISAT
+  if(argc < 2) {
+    std::cout << "usage: " << argv[0] << " <magic number> [multiplier...] # even = boolector;metaSMT, odd = metaSMT;boolector " << std::endl;
+    std::cout << "  every multiplier (array, wallace, dadda, booth) is additionally run with metaSMT BitBlast/MiniSAT" << std::endl;
+    exit(1);
+  }
+#else
   if(argc != 2) {
     std::cout << "usage: " << argv[0] << " <magic number> # even = boolector;metaSMT, odd = metaSMT;boolector " << std::endl;
     exit(1);
   }
+#endif
   
   time_t seed = time(0);
   srand(seed);
@@ -124,7 +149,7 @@ int main(int argc, const char *argv[])
   if ( atoi(argv[1]) & 1u) {
 
   std::cout << "Running metaSMT" << std::endl;
-  mtime = run(run_metaSMT);
+  mtime = run(run_metaSMT<BoolectorContext>);
 
   std::cout << "Running Boolector" << std::endl;
   btime = run( run_btor);
@@ -134,12 +159,20 @@ int main(int argc, const char *argv[])
   btime += run( run_btor);
 
   std::cout << "Running metaSMT" << std::endl;
-  mtime += run(run_metaSMT);
+  mtime += run(run_metaSMT<BoolectorContext>);
 
   }
 
   result( "metaSMT", mtime);
   result( "boolector", btime);
 
+#ifdef WITH_MINISAT
+  for (int i = 2; i < argc; ++i) {
+    multiplier = argv[i];
+    std::cout << "Running metaSMT BitBlast/MiniSAT (" << multiplier << ")" << std::endl;
+    result( "metaSMT BitBlast/MiniSAT " + multiplier, run(run_metaSMT<MiniSATContext>) );
+  }
+#endif
+
   return  mtime + btime + all_valids == 0;
 }
@@ -2,10 +2,18 @@
 #include <metaSMT/backend/SWORD_Backend.hpp>
 #include <metaSMT/backend/Z3_Backend.hpp>
 #include <metaSMT/DirectSolver_Context.hpp>
+#ifdef WITH_MINISAT
+#include <metaSMT/backend/SAT_Clause.hpp>
+#include <metaSMT/backend/MiniSAT.hpp>
+#include <metaSMT/BitBlast.hpp>
+#endif
 #include <metaSMT/support/run_algorithm.hpp>
 
 #include <boost/mpl/vector.hpp>
 #include <boost/format.hpp>
+#include <boost/timer.hpp>
+
+#include <algorithm>
 
  
 using namespace metaSMT;
@@ -14,14 +22,39 @@ using namespace metaSMT::logic::QF_BV;
 using namespace metaSMT::solver;
 using namespace std; 
 
+// clauses handed to MiniSAT, stays 0 for the other solvers
+static unsigned long minisat_clauses = 0;
+
+#ifdef WITH_MINISAT
+/**
+ * MiniSAT that counts the clauses it receives, used to compare the
+ * size of the CNF of the BitBlast multiplier encodings.
+ **/
+struct CountingMiniSAT : public MiniSAT
+{
+  void add_clauses ( SAT::clause_span const& cls )
+  {
+    minisat_clauses += std::count_if ( cls.first, cls.last, is_terminator );
+    MiniSAT::add_clauses ( cls );
+  }
+
+  static bool is_terminator ( SAT::tag::lit_tag lit )
+  {
+    return lit.id == 0;
+  }
+};
+#endif
 
 template<typename Solver>
 struct my_algo
 {
   typedef int result_type;
 
-  my_algo ( unsigned width ) :
-    width_ (width) {}; 
+  my_algo ( unsigned width, std::string multiplier ) :
+    width_ (width)
+  {
+    set_option( ctx, "bitblast_multiplier", multiplier );
+  };
 
   result_type operator()() 
   {
@@ -31,6 +64,9 @@ struct my_algo
     bitvector b = new_bitvector(width);
     bitvector c = new_bitvector(2*width);
 
+    boost::timer timer;
+    minisat_clauses = 0;
+
     bitvector zero = new_bitvector(width);
     assertion( ctx, equal(zero, bvuint(0,width)) );
     assertion( ctx, nequal(a, bvuint(1,width)) );
@@ -38,6 +74,9 @@ struct my_algo
 
     assertion( ctx, equal(c, bvmul( concat(zero, a), concat(zero,b)) ));
 
+    std::cout << boost::format("encoded in %.2fs, %lu clauses")
+      % timer.elapsed() % minisat_clauses << std::endl;
+
     int valids = 0; 
     for (unsigned i = 0; i < 10; i++) 
     {
@@ -55,6 +94,7 @@ struct my_algo
       }
     }
 
+    std::cout << boost::format("total time %.2fs") % timer.elapsed() << std::endl;
 
     return valids; 
   }
@@ -70,21 +110,36 @@ using namespace std;
 
 int main(int argc, const char *argv[])
 {
+#ifdef WITH_MINISAT
+  typedef mpl::vector3 <
+    DirectSolver_Context< SWORD_Backend >
+  , DirectSolver_Context< Z3_Backend > 
+  , DirectSolver_Context< BitBlast < SAT_Clause < CountingMiniSAT > > >
+  > SolverVec;
+#else
   typedef mpl::vector2 < 
     DirectSolver_Context< SWORD_Backend >
   , DirectSolver_Context< Z3_Backend > 
   > SolverVec;
+#endif
 
   if( argc < 3) {
-    cout << "usage: example3 solver width\nsolver:\n\t0 - SWORD\n\t1 - Z3" << endl;
+    cout << "usage: factorization solver width [multiplier]\n"
+            "solver:\n\t0 - SWORD\n\t1 - Z3\n"
+#ifdef WITH_MINISAT
+            "\t2 - MiniSAT (BitBlast)\n"
+#endif
+            "multiplier (BitBlast only):\n\tarray (default), wallace, dadda, booth"
+         << endl;
     exit(1);
   }
 
 
   unsigned solver = atoi ( argv[1] ); 
   unsigned width  = atoi ( argv[2] ); 
+  std::string multiplier = argc > 3 ? argv[3] : "array";
 
-  int val = run_algorithm<SolverVec, my_algo> ( solver, width );
+  int val = run_algorithm<SolverVec, my_algo> ( solver, width, multiplier );
 
   cout << "Got " << val << endl;
   